@@ -0,0 +1,160 @@
+/**************************************************************************
+**  This file is part of Fossil VCS plugin for Qt Creator
+**
+**  Copyright (c) 2013 - 2017, Artur Shepilko, <qtc-fossil@nomadbyte.com>.
+**
+**  Based on Bazaar VCS plugin for Qt Creator by Hugues Delorme.
+**
+**  Permission is hereby granted, free of charge, to any person obtaining a copy
+**  of this software and associated documentation files (the "Software"), to deal
+**  in the Software without restriction, including without limitation the rights
+**  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+**  copies of the Software, and to permit persons to whom the Software is
+**  furnished to do so, subject to the following conditions:
+**
+**  The above copyright notice and this permission notice shall be included in
+**  all copies or substantial portions of the Software.
+**
+**  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+**  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+**  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+**  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+**  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+**  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+**  THE SOFTWARE.
+**************************************************************************/
+
+#include "binarycapabilities.h"
+#include "fossilclient.h"
+#include "outputlines.h"
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QFileInfo>
+#include <QRegularExpression>
+#include <QSettings>
+
+namespace Fossil {
+namespace Internal {
+
+static const char settingsGroup[] = "FossilBinaryCapabilities";
+
+static qint64 modifiedMSecs(const QFileInfo &binary)
+{
+    return binary.lastModified().toMSecsSinceEpoch();
+}
+
+// One settings group per binary path
+static QString settingsKey(const QString &binaryPath)
+{
+    return QString::fromLatin1(QCryptographicHash::hash(binaryPath.toUtf8(),
+                                                        QCryptographicHash::Sha1).toHex());
+}
+
+bool BinaryCapabilities::isValid() const
+{
+    return version != 0;
+}
+
+bool BinaryCapabilities::matches(const QFileInfo &binary) const
+{
+    return binaryPath == binary.absoluteFilePath()
+            && binarySize == binary.size()
+            && binaryModified == modifiedMSecs(binary);
+}
+
+BinaryCapabilities BinaryCapabilities::fromVersionOutput(const QFileInfo &binary, const QString &output)
+{
+    // fossil version -v:
+    // "This is fossil version 2.10 [9d3bd4a5a0] 2019-10-04 14:27:21 UTC"
+    // "Compiled on Oct  4 2019 at 14:35:00 using gcc 9.2 (64-bit)"
+    // "SSL (OpenSSL 1.1.1d  10 Sep 2019)"
+    // "JSON (API 20120713)"
+    // ...
+    static const QRegularExpression versionPattern("(\\d+)\\.(\\d+)");
+
+    BinaryCapabilities capabilities;
+    OutputLines lines(output);
+    auto it = lines.begin();
+    if (it == lines.end())
+        return capabilities;
+
+    const QRegularExpressionMatch versionMatch = versionPattern.match(*it);
+    if (!versionMatch.hasMatch())
+        return capabilities;
+
+    capabilities.binaryPath = binary.absoluteFilePath();
+    capabilities.binaryModified = modifiedMSecs(binary);
+    capabilities.binarySize = binary.size();
+    capabilities.version = FossilClient::makeVersionNumber(versionMatch.captured(1).toInt(),
+                                                           versionMatch.captured(2).toInt(), 0);
+    capabilities.features = FossilClient::featuresForVersion(capabilities.version);
+
+    for (++it; it != lines.end(); ++it) {
+        const QStringRef line = it->trimmed();
+        capabilities.buildOptions << line.toString();
+        if (line.startsWith(QLatin1String("JSON")))
+            capabilities.hasJsonApi = true;
+    }
+    return capabilities;
+}
+
+BinaryCapabilities BinaryCapabilities::load(QSettings *settings, const QFileInfo &binary)
+{
+    BinaryCapabilities capabilities;
+    settings->beginGroup(settingsGroup);
+    settings->beginGroup(settingsKey(binary.absoluteFilePath()));
+    capabilities.binaryPath = settings->value("path").toString();
+    capabilities.binaryModified = settings->value("modified", 0).toLongLong();
+    capabilities.binarySize = settings->value("size", -1).toLongLong();
+    capabilities.version = settings->value("version", 0).toUInt();
+    // Not persisted, so that the features of new plugin versions apply right away
+    capabilities.features = FossilClient::featuresForVersion(capabilities.version);
+    capabilities.hasJsonApi = settings->value("jsonApi", false).toBool();
+    capabilities.buildOptions = settings->value("buildOptions").toStringList();
+    settings->endGroup();
+    settings->endGroup();
+
+    if (!capabilities.matches(binary))
+        return BinaryCapabilities();
+    return capabilities;
+}
+
+void BinaryCapabilities::save(QSettings *settings) const
+{
+    if (!isValid())
+        return;
+
+    settings->beginGroup(settingsGroup);
+    settings->beginGroup(settingsKey(binaryPath));
+    settings->setValue("path", binaryPath);
+    settings->setValue("modified", binaryModified);
+    settings->setValue("size", binarySize);
+    settings->setValue("version", version);
+    settings->remove("features"); // stored by earlier versions
+    settings->setValue("jsonApi", hasJsonApi);
+    settings->setValue("buildOptions", buildOptions);
+    settings->endGroup();
+    settings->endGroup();
+}
+
+void BinaryCapabilities::remove(QSettings *settings, const QFileInfo &binary)
+{
+    settings->beginGroup(settingsGroup);
+    settings->remove(settingsKey(binary.absoluteFilePath()));
+    settings->endGroup();
+}
+
+bool operator==(const BinaryCapabilities &lh, const BinaryCapabilities &rh)
+{
+    return lh.binaryPath == rh.binaryPath
+            && lh.binaryModified == rh.binaryModified
+            && lh.binarySize == rh.binarySize
+            && lh.version == rh.version
+            && lh.features == rh.features
+            && lh.hasJsonApi == rh.hasJsonApi
+            && lh.buildOptions == rh.buildOptions;
+}
+
+} // namespace Internal
+} // namespace Fossil
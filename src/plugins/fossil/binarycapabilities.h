@@ -0,0 +1,69 @@
+/**************************************************************************
+**  This file is part of Fossil VCS plugin for Qt Creator
+**
+**  Copyright (c) 2013 - 2017, Artur Shepilko, <qtc-fossil@nomadbyte.com>.
+**
+**  Based on Bazaar VCS plugin for Qt Creator by Hugues Delorme.
+**
+**  Permission is hereby granted, free of charge, to any person obtaining a copy
+**  of this software and associated documentation files (the "Software"), to deal
+**  in the Software without restriction, including without limitation the rights
+**  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+**  copies of the Software, and to permit persons to whom the Software is
+**  furnished to do so, subject to the following conditions:
+**
+**  The above copyright notice and this permission notice shall be included in
+**  all copies or substantial portions of the Software.
+**
+**  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+**  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+**  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+**  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+**  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+**  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+**  THE SOFTWARE.
+**************************************************************************/
+
+#pragma once
+
+#include <QString>
+#include <QStringList>
+
+QT_BEGIN_NAMESPACE
+class QFileInfo;
+class QSettings;
+QT_END_NAMESPACE
+
+namespace Fossil {
+namespace Internal {
+
+// What a fossil binary is capable of, as probed by "fossil version -v".
+// Records are persisted per binary and stay valid as long as the binary's
+// modification time and size match, i.e. until it is replaced.
+class BinaryCapabilities
+{
+public:
+    QString binaryPath;
+    qint64 binaryModified = 0; // msecs since epoch
+    qint64 binarySize = -1;
+
+    unsigned int version = 0;
+    unsigned int features = 0; // FossilClient::SupportedFeatures, derived from the version
+    bool hasJsonApi = false;
+    QStringList buildOptions; // e.g. "SSL (OpenSSL 1.1.1d  10 Sep 2019)"
+
+    bool isValid() const;
+    bool matches(const QFileInfo &binary) const;
+
+    static BinaryCapabilities fromVersionOutput(const QFileInfo &binary, const QString &output);
+
+    static BinaryCapabilities load(QSettings *settings, const QFileInfo &binary);
+    void save(QSettings *settings) const;
+    static void remove(QSettings *settings, const QFileInfo &binary);
+};
+
+bool operator==(const BinaryCapabilities &lh, const BinaryCapabilities &rh);
+inline bool operator!=(const BinaryCapabilities &lh, const BinaryCapabilities &rh) { return !(lh == rh); }
+
+} // namespace Internal
+} // namespace Fossil
@@ -0,0 +1,182 @@
+/**************************************************************************
+**  This file is part of Fossil VCS plugin for Qt Creator
+**
+**  Copyright (c) 2013 - 2017, Artur Shepilko, <qtc-fossil@nomadbyte.com>.
+**
+**  Based on Bazaar VCS plugin for Qt Creator by Hugues Delorme.
+**
+**  Permission is hereby granted, free of charge, to any person obtaining a copy
+**  of this software and associated documentation files (the "Software"), to deal
+**  in the Software without restriction, including without limitation the rights
+**  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+**  copies of the Software, and to permit persons to whom the Software is
+**  furnished to do so, subject to the following conditions:
+**
+**  The above copyright notice and this permission notice shall be included in
+**  all copies or substantial portions of the Software.
+**
+**  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+**  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+**  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+**  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+**  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+**  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+**  THE SOFTWARE.
+**************************************************************************/
+
+#include "blockingdetector.h"
+#include "commandstatistics.h"
+
+#include <QDir>
+#include <QFile>
+#include <QLoggingCategory>
+#include <QMap>
+#include <QStringList>
+#include <QTextStream>
+
+namespace Fossil {
+namespace Internal {
+
+static Q_LOGGING_CATEGORY(blockingLog, "qtc.fossil.blocking")
+
+// Call sites are only tracked on the GUI thread
+static QStringList callSites;
+
+BlockingDetector::CallSite::CallSite(const char *name)
+{
+    if (!CommandStatistics::isGuiThread())
+        return;
+    callSites.append(QString::fromLatin1(name));
+    m_open = true;
+}
+
+BlockingDetector::CallSite::~CallSite()
+{
+    if (m_open)
+        callSites.removeLast();
+}
+
+BlockingDetector::BlockingDetector(QObject *parent) :
+    QObject(parent)
+{
+    m_thresholdMs = qMax(0, qEnvironmentVariableIntValue("QTC_FOSSIL_BLOCKING_THRESHOLD"));
+    m_reportFile = QString::fromLocal8Bit(qgetenv("QTC_FOSSIL_BLOCKING_REPORT"));
+}
+
+bool BlockingDetector::isEnabled() const
+{
+    return m_thresholdMs > 0;
+}
+
+int BlockingDetector::thresholdMs() const
+{
+    return m_thresholdMs;
+}
+
+void BlockingDetector::setThresholdMs(int thresholdMs)
+{
+    m_thresholdMs = qMax(0, thresholdMs);
+}
+
+QString BlockingDetector::reportFile() const
+{
+    return m_reportFile;
+}
+
+void BlockingDetector::setReportFile(const QString &reportFile)
+{
+    m_reportFile = reportFile;
+}
+
+QString BlockingDetector::currentCallSite()
+{
+    return callSites.isEmpty() ? tr("<unknown>") : callSites.join(" > ");
+}
+
+void BlockingDetector::check(const CommandRecord &record)
+{
+    if (!isEnabled() || !record.guiThread || record.exec != CommandRecord::FullySynchronous
+            || record.durationUs < m_thresholdMs * 1000ll) {
+        return;
+    }
+
+    Wait wait;
+    wait.callSite = currentCallSite();
+    wait.verb = record.verb;
+    wait.workingDirectory = record.workingDirectory;
+    wait.durationUs = record.durationUs;
+    m_waits.append(wait);
+
+    qCWarning(blockingLog, "GUI thread blocked for %lld ms by \"fossil %s\" in %s at %s",
+              record.durationUs / 1000, qPrintable(record.verb),
+              qPrintable(QDir::toNativeSeparators(record.workingDirectory)),
+              qPrintable(wait.callSite));
+}
+
+QVector<BlockingDetector::Wait> BlockingDetector::waits() const
+{
+    return m_waits;
+}
+
+void BlockingDetector::clear()
+{
+    m_waits.clear();
+}
+
+QString BlockingDetector::report() const
+{
+    struct Entry {
+        int count = 0;
+        qint64 totalUs = 0;
+        qint64 maxUs = 0;
+    };
+    QMap<QString, Entry> entries;
+    qint64 totalUs = 0;
+    for (const Wait &wait : m_waits) {
+        Entry &entry = entries[wait.callSite + " > " + wait.verb];
+        ++entry.count;
+        entry.totalUs += wait.durationUs;
+        entry.maxUs = qMax(entry.maxUs, wait.durationUs);
+        totalUs += wait.durationUs;
+    }
+
+    QString report;
+    QTextStream str(&report);
+    str << "Fossil GUI thread blocking report\n"
+        << "Threshold: " << m_thresholdMs << " ms\n"
+        << "Blocking waits: " << m_waits.size() << " (total " << totalUs / 1000 << " ms)\n";
+    if (entries.isEmpty())
+        return report;
+
+    str << '\n' << qSetFieldWidth(8) << right << "Count" << "Total ms" << "Max ms"
+        << qSetFieldWidth(0) << "  Call site\n";
+    for (auto it = entries.cbegin(); it != entries.cend(); ++it) {
+        str << qSetFieldWidth(8) << it->count << it->totalUs / 1000 << it->maxUs / 1000
+            << qSetFieldWidth(0) << "  " << it.key() << '\n';
+    }
+    return report;
+}
+
+bool BlockingDetector::writeReport() const
+{
+    if (!isEnabled())
+        return true;
+
+    const QString text = report();
+    if (m_reportFile.isEmpty()) {
+        qCWarning(blockingLog, "%s", qPrintable(text));
+        return true;
+    }
+
+    QFile file(m_reportFile);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)
+            || file.write(text.toUtf8()) < 0) {
+        qCWarning(blockingLog, "Cannot write %s: %s", qPrintable(m_reportFile),
+                  qPrintable(file.errorString()));
+        return false;
+    }
+    return true;
+}
+
+} // namespace Internal
+} // namespace Fossil
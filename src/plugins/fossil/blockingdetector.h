@@ -0,0 +1,92 @@
+/**************************************************************************
+**  This file is part of Fossil VCS plugin for Qt Creator
+**
+**  Copyright (c) 2013 - 2017, Artur Shepilko, <qtc-fossil@nomadbyte.com>.
+**
+**  Based on Bazaar VCS plugin for Qt Creator by Hugues Delorme.
+**
+**  Permission is hereby granted, free of charge, to any person obtaining a copy
+**  of this software and associated documentation files (the "Software"), to deal
+**  in the Software without restriction, including without limitation the rights
+**  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+**  copies of the Software, and to permit persons to whom the Software is
+**  furnished to do so, subject to the following conditions:
+**
+**  The above copyright notice and this permission notice shall be included in
+**  all copies or substantial portions of the Software.
+**
+**  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+**  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+**  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+**  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+**  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+**  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+**  THE SOFTWARE.
+**************************************************************************/
+
+#pragma once
+
+#include <QObject>
+#include <QVector>
+
+namespace Fossil {
+namespace Internal {
+
+struct CommandRecord;
+
+// Flags fossil processes the GUI thread waited on for longer than a threshold,
+// blocking it; waits that keep the event loop running are not flagged.
+// Diagnostics only: enabled by setting QTC_FOSSIL_BLOCKING_THRESHOLD (in ms).
+// A summary is written on shutdown to QTC_FOSSIL_BLOCKING_REPORT if set,
+// else to the log. When testing, any flagged wait fails the test run.
+class BlockingDetector : public QObject
+{
+    Q_OBJECT
+
+public:
+    // Names a scope on the GUI thread, such as an action or a FossilClient method.
+    // Blocking waits are attributed to the call sites open at the time.
+    class CallSite
+    {
+    public:
+        explicit CallSite(const char *name);
+        ~CallSite();
+
+    private:
+        bool m_open = false;
+        Q_DISABLE_COPY(CallSite)
+    };
+
+    struct Wait
+    {
+        QString callSite;
+        QString verb;
+        QString workingDirectory;
+        qint64 durationUs = 0;
+    };
+
+    explicit BlockingDetector(QObject *parent = nullptr);
+
+    bool isEnabled() const;
+    int thresholdMs() const;
+    void setThresholdMs(int thresholdMs);
+    QString reportFile() const;
+    void setReportFile(const QString &reportFile);
+
+    void check(const CommandRecord &record);
+    QVector<Wait> waits() const;
+    void clear();
+
+    QString report() const;
+    bool writeReport() const;
+
+    static QString currentCallSite();
+
+private:
+    int m_thresholdMs = 0;
+    QString m_reportFile;
+    QVector<Wait> m_waits;
+};
+
+} // namespace Internal
+} // namespace Fossil
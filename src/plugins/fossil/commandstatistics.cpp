@@ -0,0 +1,289 @@
+/**************************************************************************
+**  This file is part of Fossil VCS plugin for Qt Creator
+**
+**  Copyright (c) 2013 - 2017, Artur Shepilko, <qtc-fossil@nomadbyte.com>.
+**
+**  Based on Bazaar VCS plugin for Qt Creator by Hugues Delorme.
+**
+**  Permission is hereby granted, free of charge, to any person obtaining a copy
+**  of this software and associated documentation files (the "Software"), to deal
+**  in the Software without restriction, including without limitation the rights
+**  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+**  copies of the Software, and to permit persons to whom the Software is
+**  furnished to do so, subject to the following conditions:
+**
+**  The above copyright notice and this permission notice shall be included in
+**  all copies or substantial portions of the Software.
+**
+**  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+**  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+**  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+**  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+**  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+**  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+**  THE SOFTWARE.
+**************************************************************************/
+
+#include "commandstatistics.h"
+
+#include <vcsbase/vcscommand.h>
+
+#include <QCoreApplication>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSharedPointer>
+#include <QThread>
+
+#include <algorithm>
+
+namespace Fossil {
+namespace Internal {
+
+CommandStatistics::CommandStatistics(QObject *parent) :
+    QObject(parent)
+{
+    m_clock.start();
+}
+
+qint64 CommandStatistics::nowUs() const
+{
+    return m_clock.nsecsElapsed() / 1000;
+}
+
+bool CommandStatistics::isGuiThread()
+{
+    return QCoreApplication::instance()
+            && QThread::currentThread() == QCoreApplication::instance()->thread();
+}
+
+void CommandStatistics::record(const CommandRecord &record)
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        if (m_records.size() < maxRecords) {
+            m_records.append(record);
+        } else {
+            m_records[m_next] = record;
+            m_next = (m_next + 1) % maxRecords;
+        }
+    }
+    emit recordAdded();
+}
+
+CommandRecord CommandStatistics::record(const QString &verb, const QString &workingDirectory,
+                                        qint64 startUs, qint64 outputBytes, bool ok,
+                                        CommandRecord::Exec exec)
+{
+    CommandRecord record;
+    record.verb = verb;
+    record.workingDirectory = workingDirectory;
+    record.startUs = startUs;
+    record.durationUs = nowUs() - startUs;
+    record.outputBytes = outputBytes;
+    record.guiThread = isGuiThread();
+    record.exec = exec;
+    record.ok = ok;
+    this->record(record);
+    return record;
+}
+
+// The size of the text as fossil wrote it, without converting it back
+static qint64 utf8Size(const QString &text)
+{
+    qint64 size = 0;
+    for (const QChar c : text) {
+        const ushort u = c.unicode();
+        if (u < 0x80)
+            size += 1;
+        else if (u < 0x800 || c.isSurrogate()) // a surrogate pair takes four bytes
+            size += 2;
+        else
+            size += 3;
+    }
+    return size;
+}
+
+void CommandStatistics::instrument(VcsBase::VcsCommand *command, const QString &verb,
+                                   const QString &workingDirectory)
+{
+    // Jobs wait in the job scheduler and the command's queue, the clock starts
+    // once the command starts running them. Set in the command's thread.
+    // Commands dropped before they started spawned nothing and are not recorded.
+    QSharedPointer<qint64> startUs(new qint64(-1));
+    QSharedPointer<qint64> outputBytes(new qint64(0));
+    connect(command, &VcsBase::VcsCommand::started, this, [this, startUs]() {
+        *startUs = nowUs();
+    }, Qt::DirectConnection);
+    const auto countOutput = [outputBytes](const QString &text) { *outputBytes += utf8Size(text); };
+    connect(command, &VcsBase::VcsCommand::stdOutText, this, countOutput);
+    connect(command, &VcsBase::VcsCommand::stdErrText, this, countOutput);
+    connect(command, &VcsBase::VcsCommand::finished, this,
+            [this, verb, workingDirectory, startUs, outputBytes](bool ok) {
+        if (*startUs < 0)
+            return;
+        CommandRecord record;
+        record.verb = verb;
+        record.workingDirectory = workingDirectory;
+        record.startUs = *startUs;
+        record.durationUs = nowUs() - *startUs;
+        record.outputBytes = *outputBytes;
+        record.ok = ok;
+        this->record(record);
+    });
+}
+
+QVector<CommandRecord> CommandStatistics::records() const
+{
+    QMutexLocker locker(&m_mutex);
+    // oldest first
+    QVector<CommandRecord> records;
+    records.reserve(m_records.size());
+    for (int i = m_next; i < m_records.size(); ++i)
+        records.append(m_records.at(i));
+    for (int i = 0; i < m_next; ++i)
+        records.append(m_records.at(i));
+    return records;
+}
+
+CommandRecord CommandStatistics::lastRecord() const
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_records.isEmpty())
+        return CommandRecord();
+    return m_records.at((m_next + m_records.size() - 1) % m_records.size());
+}
+
+void CommandStatistics::clear()
+{
+    QMutexLocker locker(&m_mutex);
+    m_records.clear();
+    m_next = 0;
+    m_spawnsSaved = 0;
+}
+
+void CommandStatistics::addSpawnSaved()
+{
+    QMutexLocker locker(&m_mutex);
+    ++m_spawnsSaved;
+}
+
+int CommandStatistics::spawnsSaved() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_spawnsSaved;
+}
+
+qint64 CommandStatistics::percentile(const QVector<qint64> &sortedValues, int percent)
+{
+    if (sortedValues.isEmpty())
+        return 0;
+    // nearest-rank
+    const int rank = (percent * sortedValues.size() + 99) / 100;
+    return sortedValues.at(qBound(0, rank - 1, sortedValues.size() - 1));
+}
+
+QVector<CommandSummary> CommandStatistics::summaries() const
+{
+    QHash<QString, QVector<qint64>> durations;
+    QHash<QString, CommandSummary> summaries;
+    for (const CommandRecord &record : records()) {
+        CommandSummary &summary = summaries[record.verb];
+        summary.verb = record.verb;
+        ++summary.count;
+        if (record.guiThread)
+            ++summary.guiThreadCount;
+        summary.totalUs += record.durationUs;
+        summary.outputBytes += record.outputBytes;
+        durations[record.verb].append(record.durationUs);
+    }
+
+    QVector<CommandSummary> result;
+    for (auto it = summaries.begin(); it != summaries.end(); ++it) {
+        QVector<qint64> &values = durations[it.key()];
+        std::sort(values.begin(), values.end());
+        it->p50Us = percentile(values, 50);
+        it->p90Us = percentile(values, 90);
+        it->p99Us = percentile(values, 99);
+        it->maxUs = values.last();
+        result.append(it.value());
+    }
+
+    // most expensive first
+    std::sort(result.begin(), result.end(), [](const CommandSummary &l, const CommandSummary &r) {
+        return l.totalUs > r.totalUs;
+    });
+    return result;
+}
+
+QByteArray CommandStatistics::toJson() const
+{
+    QJsonArray records;
+    for (const CommandRecord &record : this->records()) {
+        QJsonObject object;
+        object.insert("verb", record.verb);
+        object.insert("workingDirectory", record.workingDirectory);
+        object.insert("startUs", double(record.startUs));
+        object.insert("durationUs", double(record.durationUs));
+        object.insert("outputBytes", double(record.outputBytes));
+        object.insert("guiThread", record.guiThread);
+        object.insert("exec", record.exec == CommandRecord::FullySynchronous ? "fullySynchronous"
+                            : record.exec == CommandRecord::Synchronous ? "synchronous"
+                                                                        : "asynchronous");
+        object.insert("ok", record.ok);
+        records.append(object);
+    }
+
+    QJsonArray summaries;
+    for (const CommandSummary &summary : this->summaries()) {
+        QJsonObject object;
+        object.insert("verb", summary.verb);
+        object.insert("count", summary.count);
+        object.insert("guiThreadCount", summary.guiThreadCount);
+        object.insert("p50Us", double(summary.p50Us));
+        object.insert("p90Us", double(summary.p90Us));
+        object.insert("p99Us", double(summary.p99Us));
+        object.insert("maxUs", double(summary.maxUs));
+        object.insert("totalUs", double(summary.totalUs));
+        object.insert("outputBytes", double(summary.outputBytes));
+        summaries.append(object);
+    }
+
+    QJsonObject root;
+    root.insert("records", records);
+    root.insert("summaries", summaries);
+    root.insert("spawnsSaved", spawnsSaved());
+    return QJsonDocument(root).toJson();
+}
+
+QByteArray CommandStatistics::toChromeTrace() const
+{
+    // Trace Event Format, "complete" events; GUI thread calls on a track of their own
+    QJsonArray events;
+    for (const CommandRecord &record : records()) {
+        QJsonObject args;
+        args.insert("workingDirectory", record.workingDirectory);
+        args.insert("outputBytes", double(record.outputBytes));
+        args.insert("ok", record.ok);
+
+        QJsonObject event;
+        event.insert("name", record.verb);
+        event.insert("cat", "fossil");
+        event.insert("ph", "X");
+        event.insert("ts", double(record.startUs));
+        event.insert("dur", double(record.durationUs));
+        event.insert("pid", 1);
+        event.insert("tid", record.guiThread ? 1 : 2);
+        event.insert("args", args);
+        events.append(event);
+    }
+
+    QJsonObject root;
+    root.insert("traceEvents", events);
+    root.insert("displayTimeUnit", "ms");
+    return QJsonDocument(root).toJson(QJsonDocument::Compact);
+}
+
+} // namespace Internal
+} // namespace Fossil
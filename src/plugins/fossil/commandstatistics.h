@@ -0,0 +1,118 @@
+/**************************************************************************
+**  This file is part of Fossil VCS plugin for Qt Creator
+**
+**  Copyright (c) 2013 - 2017, Artur Shepilko, <qtc-fossil@nomadbyte.com>.
+**
+**  Based on Bazaar VCS plugin for Qt Creator by Hugues Delorme.
+**
+**  Permission is hereby granted, free of charge, to any person obtaining a copy
+**  of this software and associated documentation files (the "Software"), to deal
+**  in the Software without restriction, including without limitation the rights
+**  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+**  copies of the Software, and to permit persons to whom the Software is
+**  furnished to do so, subject to the following conditions:
+**
+**  The above copyright notice and this permission notice shall be included in
+**  all copies or substantial portions of the Software.
+**
+**  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+**  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+**  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+**  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+**  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+**  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+**  THE SOFTWARE.
+**************************************************************************/
+
+#pragma once
+
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QObject>
+#include <QVector>
+
+namespace VcsBase { class VcsCommand; }
+
+namespace Fossil {
+namespace Internal {
+
+struct CommandRecord
+{
+    enum Exec {
+        Asynchronous,       // a job in the command's thread
+        Synchronous,        // waited on running an event loop (vcsSynchronousExec)
+        FullySynchronous    // waited on blocking the thread (vcsFullySynchronousExec)
+    };
+
+    QString verb;
+    QString workingDirectory;
+    qint64 startUs = 0;    // since the statistics were started
+    qint64 durationUs = 0; // wall time from the start, the time a job was queued is not included
+    qint64 outputBytes = 0; // as UTF-8
+    bool guiThread = false;
+    Exec exec = Asynchronous;
+    bool ok = false;
+};
+
+struct CommandSummary
+{
+    QString verb;
+    int count = 0;
+    int guiThreadCount = 0;
+    qint64 p50Us = 0;
+    qint64 p90Us = 0;
+    qint64 p99Us = 0;
+    qint64 maxUs = 0;
+    qint64 totalUs = 0;
+    qint64 outputBytes = 0;
+};
+
+// Records every fossil process spawned by the plugin. Synchronous calls are
+// recorded by the caller, asynchronous commands once they are finished.
+// The most recent maxRecords records are kept; may be used from any thread.
+class CommandStatistics : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit CommandStatistics(QObject *parent = nullptr);
+
+    qint64 nowUs() const;
+    static bool isGuiThread();
+
+    void record(const CommandRecord &record);
+    CommandRecord record(const QString &verb, const QString &workingDirectory, qint64 startUs,
+                         qint64 outputBytes, bool ok,
+                         CommandRecord::Exec exec = CommandRecord::Asynchronous);
+    void instrument(VcsBase::VcsCommand *command, const QString &verb,
+                    const QString &workingDirectory);
+
+    QVector<CommandRecord> records() const;
+    CommandRecord lastRecord() const;
+    QVector<CommandSummary> summaries() const;
+    void clear();
+
+    // Queries merged into an identical one already running
+    void addSpawnSaved();
+    int spawnsSaved() const;
+
+    QByteArray toJson() const;
+    QByteArray toChromeTrace() const;
+
+    static qint64 percentile(const QVector<qint64> &sortedValues, int percent);
+
+    static const int maxRecords = 10000;
+
+signals:
+    void recordAdded();
+
+private:
+    mutable QMutex m_mutex;
+    QVector<CommandRecord> m_records;
+    int m_next = 0; // oldest record once full
+    int m_spawnsSaved = 0;
+    QElapsedTimer m_clock;
+};
+
+} // namespace Internal
+} // namespace Fossil
@@ -0,0 +1,151 @@
+/**************************************************************************
+**  This file is part of Fossil VCS plugin for Qt Creator
+**
+**  Copyright (c) 2013 - 2017, Artur Shepilko, <qtc-fossil@nomadbyte.com>.
+**
+**  Based on Bazaar VCS plugin for Qt Creator by Hugues Delorme.
+**
+**  Permission is hereby granted, free of charge, to any person obtaining a copy
+**  of this software and associated documentation files (the "Software"), to deal
+**  in the Software without restriction, including without limitation the rights
+**  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+**  copies of the Software, and to permit persons to whom the Software is
+**  furnished to do so, subject to the following conditions:
+**
+**  The above copyright notice and this permission notice shall be included in
+**  all copies or substantial portions of the Software.
+**
+**  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+**  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+**  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+**  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+**  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+**  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+**  THE SOFTWARE.
+**************************************************************************/
+
+#include "commandstatisticsdialog.h"
+#include "ui_commandstatisticsdialog.h"
+
+#include "commandstatistics.h"
+
+#include <QFile>
+#include <QFileDialog>
+#include <QMessageBox>
+
+namespace Fossil {
+namespace Internal {
+
+class CommandStatisticsDialogPrivate {
+public:
+    Ui::CommandStatisticsDialog m_ui;
+    CommandStatistics *m_statistics = nullptr;
+};
+
+static QVariant milliseconds(qint64 us)
+{
+    return QVariant(qRound(us / 100.0) / 10.0);
+}
+
+CommandStatisticsDialog::CommandStatisticsDialog(CommandStatistics *statistics, QWidget *parent) :
+    QDialog(parent),
+    d(new CommandStatisticsDialogPrivate)
+{
+    d->m_statistics = statistics;
+    d->m_ui.setupUi(this);
+    setAttribute(Qt::WA_DeleteOnClose);
+
+    connect(d->m_ui.exportJsonButton, &QPushButton::clicked, this, [this] { exportData(false); });
+    connect(d->m_ui.exportTraceButton, &QPushButton::clicked, this, [this] { exportData(true); });
+    connect(d->m_ui.clearButton, &QPushButton::clicked, this, [this] {
+        d->m_statistics->clear();
+        updateSummary();
+    });
+    connect(statistics, &CommandStatistics::recordAdded, this, &CommandStatisticsDialog::updateSummary,
+            Qt::QueuedConnection);
+
+    updateSummary();
+}
+
+CommandStatisticsDialog::~CommandStatisticsDialog()
+{
+    delete d;
+}
+
+void CommandStatisticsDialog::updateSummary()
+{
+    QTreeWidget *tree = d->m_ui.summaryTreeWidget;
+    tree->setSortingEnabled(false);
+    tree->clear();
+
+    int count = 0;
+    int guiThreadCount = 0;
+    qint64 guiThreadUs = 0;
+    for (const CommandRecord &record : d->m_statistics->records()) {
+        ++count;
+        if (record.guiThread) {
+            ++guiThreadCount;
+            guiThreadUs += record.durationUs;
+        }
+    }
+
+    for (const CommandSummary &summary : d->m_statistics->summaries()) {
+        auto item = new QTreeWidgetItem(tree);
+        item->setText(0, summary.verb);
+        item->setData(1, Qt::DisplayRole, summary.count);
+        item->setData(2, Qt::DisplayRole, summary.guiThreadCount);
+        item->setData(3, Qt::DisplayRole, milliseconds(summary.p50Us));
+        item->setData(4, Qt::DisplayRole, milliseconds(summary.p90Us));
+        item->setData(5, Qt::DisplayRole, milliseconds(summary.p99Us));
+        item->setData(6, Qt::DisplayRole, milliseconds(summary.maxUs));
+        item->setData(7, Qt::DisplayRole, milliseconds(summary.totalUs));
+        item->setData(8, Qt::DisplayRole, summary.outputBytes);
+        for (int column = 1; column < tree->columnCount(); ++column)
+            item->setTextAlignment(column, Qt::AlignRight | Qt::AlignVCenter);
+    }
+
+    tree->setSortingEnabled(true);
+    for (int column = 0; column < tree->columnCount(); ++column)
+        tree->resizeColumnToContents(column);
+
+    d->m_ui.totalsLabel->setText(tr("%n fossil processes spawned, %1 of them blocking the GUI thread for %2 ms.",
+                                    nullptr, count)
+                                 .arg(guiThreadCount)
+                                 .arg(milliseconds(guiThreadUs).toString())
+                                 + ' '
+                                 + tr("%n spawns saved by merging identical queries.",
+                                      nullptr, d->m_statistics->spawnsSaved()));
+}
+
+void CommandStatisticsDialog::exportData(bool chromeTrace)
+{
+    const QString fileName = QFileDialog::getSaveFileName(
+                this, chromeTrace ? tr("Export Trace") : tr("Export JSON"),
+                QString(), tr("JSON Files (*.json)"));
+    if (fileName.isEmpty())
+        return;
+
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)
+            || file.write(chromeTrace ? d->m_statistics->toChromeTrace()
+                                      : d->m_statistics->toJson()) < 0) {
+        QMessageBox::warning(this, windowTitle(),
+                             tr("Cannot write %1: %2").arg(fileName, file.errorString()));
+    }
+}
+
+void CommandStatisticsDialog::changeEvent(QEvent *e)
+{
+    QDialog::changeEvent(e);
+    switch (e->type()) {
+    case QEvent::LanguageChange:
+        d->m_ui.retranslateUi(this);
+        updateSummary();
+        break;
+    default:
+        break;
+    }
+}
+
+} // namespace Internal
+} // namespace Fossil
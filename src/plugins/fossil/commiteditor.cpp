@@ -31,12 +31,45 @@
 
 #include <coreplugin/idocument.h>
 #include <vcsbase/submitfilemodel.h>
-#include <utils/algorithm.h>
 #include <utils/qtcassert.h>
 
 namespace Fossil {
 namespace Internal {
 
+// Submit file model populated straight from the status list.
+// The model is filled before it is set on the view, so adding the rows one
+// by one notifies nobody; skipping the unknown files in place saves copying
+// the status list.
+class CommitFileModel : public VcsBase::SubmitFileModel
+{
+public:
+    explicit CommitFileModel(QObject *parent) : VcsBase::SubmitFileModel(parent)
+    { }
+
+    void addFiles(const QList<VcsBase::VcsBaseClient::StatusItem> &items, const QString &skipFlags)
+    {
+        for (const VcsBase::VcsBaseClient::StatusItem &item : items) {
+            if (item.flags != skipFlags)
+                addFile(item.file, item.flags, Checked, commitPath(item.file));
+        }
+    }
+
+    QString commitFile(int row) const
+    {
+        const QVariant path = extraData(row);
+        return (path.isValid() ? path.toString() : file(row));
+    }
+
+private:
+    static QVariant commitPath(const QString &file)
+    {
+        // Renamed entries are listed as "file => newfile", only 'newfile'
+        // is to be passed to the commit.
+        const int pos = file.indexOf(" => ");
+        return (pos != -1 ? QVariant(file.mid(pos + 4)) : QVariant());
+    }
+};
+
 CommitEditor::CommitEditor(const VcsBase::VcsBaseSubmitEditorParameters *parameters) :
     VcsBase::VcsBaseSubmitEditor(parameters, new FossilCommitWidget)
 {
@@ -57,7 +90,7 @@ void CommitEditor::setFields(const QString &repositoryRoot, const BranchInfo &br
 
     fossilWidget->setFields(repositoryRoot, branch, tags, userName);
 
-    m_fileModel = new VcsBase::SubmitFileModel(this);
+    m_fileModel = new CommitFileModel(this);
     m_fileModel->setRepositoryRoot(repositoryRoot);
     m_fileModel->setFileStatusQualifier([](const QString &status, const QVariant &)
                                            -> VcsBase::SubmitFileModel::FileStatusHint
@@ -78,13 +111,25 @@ void CommitEditor::setFields(const QString &repositoryRoot, const BranchInfo &br
         return VcsBase::SubmitFileModel::FileStatusUnknown;
     } );
 
-    const QList<VcsBase::VcsBaseClient::StatusItem> toAdd = Utils::filtered(repoStatus,
-                [](const VcsBase::VcsBaseClient::StatusItem &item) { return item.flags != Constants::FSTATUS_UNKNOWN; });
-    for (const VcsBase::VcsBaseClient::StatusItem &item : toAdd)
-            m_fileModel->addFile(item.file, item.flags);
+    m_fileModel->addFiles(repoStatus, Constants::FSTATUS_UNKNOWN);
 
     setFileModel(m_fileModel);
 }
 
+QStringList CommitEditor::checkedCommitFiles() const
+{
+    QStringList files;
+    if (!m_fileModel)
+        return files;
+
+    const int rowCount = m_fileModel->rowCount();
+    files.reserve(rowCount);
+    for (int row = 0; row < rowCount; ++row) {
+        if (m_fileModel->checked(row))
+            files.append(m_fileModel->commitFile(row));
+    }
+    return files;
+}
+
 } // namespace Internal
 } // namespace Fossil
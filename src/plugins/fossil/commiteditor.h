@@ -29,12 +29,11 @@
 #include <vcsbase/vcsbaseclient.h>
 #include <vcsbase/vcsbasesubmiteditor.h>
 
-namespace VcsBase { class SubmitFileModel; }
-
 namespace Fossil {
 namespace Internal {
 
 class BranchInfo;
+class CommitFileModel;
 class FossilCommitWidget;
 
 class CommitEditor : public VcsBase::VcsBaseSubmitEditor
@@ -49,9 +48,10 @@ public:
                    const QList<VcsBase::VcsBaseClient::StatusItem> &repoStatus);
 
     FossilCommitWidget *commitWidget();
+    QStringList checkedCommitFiles() const;
 
 private:
-    VcsBase::SubmitFileModel *m_fileModel = nullptr;
+    CommitFileModel *m_fileModel = nullptr;
 };
 
 } // namespace Internal
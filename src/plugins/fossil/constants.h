@@ -89,6 +89,8 @@ const char LOGMULTI[] = "Fossil.Action.LogMulti";
 //repository menu actions
 const char PULL[] = "Fossil.Action.Pull";
 const char PUSH[] = "Fossil.Action.Push";
+const char SYNC_ALL[] = "Fossil.Action.SyncAll";
+const char COMMAND_STATISTICS[] = "Fossil.Action.CommandStatistics";
 const char UPDATE[] = "Fossil.Action.Update";
 const char COMMIT[] = "Fossil.Action.Commit";
 const char CONFIGURE_REPOSITORY[] = "Fossil.Action.Settings";
@@ -1,18 +1,34 @@
+QT += network
 include(../../qtcreatorplugin.pri)
 SOURCES += \
     fossilclient.cpp \
     fossilcontrol.cpp \
     fossilplugin.cpp \
     optionspage.cpp \
+    outputlines.cpp \
     fossilsettings.cpp \
     commiteditor.cpp \
     fossilcommitwidget.cpp \
     fossileditor.cpp \
+    inflightqueries.cpp \
+    jobscheduler.cpp \
+    loghighlighter.cpp \
     annotationhighlighter.cpp \
+    binarycapabilities.cpp \
+    blockingdetector.cpp \
     pullorpushdialog.cpp \
     branchinfo.cpp \
+    commandstatistics.cpp \
+    commandstatisticsdialog.cpp \
     configuredialog.cpp \
     revisioninfo.cpp \
+    pullscheduler.cpp \
+    statustracker.cpp \
+    syncallrunner.cpp \
+    syncprogressparser.cpp \
+    syncproxy.cpp \
+    templatepool.cpp \
+    toplevelcache.cpp \
     wizard/fossiljsextension.cpp
 HEADERS += \
     fossilclient.h \
@@ -20,20 +36,36 @@ HEADERS += \
     fossilcontrol.h \
     fossilplugin.h \
     optionspage.h \
+    outputlines.h \
     fossilsettings.h \
     commiteditor.h \
     fossilcommitwidget.h \
     fossileditor.h \
+    inflightqueries.h \
+    jobscheduler.h \
+    loghighlighter.h \
     annotationhighlighter.h \
+    binarycapabilities.h \
+    blockingdetector.h \
     pullorpushdialog.h \
     branchinfo.h \
+    commandstatistics.h \
+    commandstatisticsdialog.h \
     configuredialog.h \
     revisioninfo.h \
+    pullscheduler.h \
+    statustracker.h \
+    syncallrunner.h \
+    syncprogressparser.h \
+    syncproxy.h \
+    templatepool.h \
+    toplevelcache.h \
     wizard/fossiljsextension.h
 FORMS += \
     optionspage.ui \
     revertdialog.ui \
     fossilcommitpanel.ui \
     pullorpushdialog.ui \
-    configuredialog.ui
+    configuredialog.ui \
+    commandstatisticsdialog.ui
 RESOURCES += fossil.qrc
@@ -24,10 +24,22 @@
 **  THE SOFTWARE.
 **************************************************************************/
 
+#include "blockingdetector.h"
+#include "commandstatistics.h"
 #include "fossilclient.h"
 #include "fossileditor.h"
+#include "inflightqueries.h"
+#include "jobscheduler.h"
+#include "loghighlighter.h"
+#include "outputlines.h"
+#include "statustracker.h"
+#include "syncprogressparser.h"
+#include "syncproxy.h"
+#include "templatepool.h"
+#include "toplevelcache.h"
 #include "constants.h"
 
+#include <coreplugin/icore.h>
 #include <coreplugin/id.h>
 
 #include <vcsbase/vcsbaseplugin.h>
@@ -40,20 +52,46 @@
 #include <utils/fileutils.h>
 #include <utils/hostosinfo.h>
 #include <utils/qtcassert.h>
-
-#include <QSyntaxHighlighter>
+#include <utils/runextensions.h>
 
 #include <QDateTime>
 #include <QDir>
+#include <QElapsedTimer>
 #include <QFile>
 #include <QFileInfo>
+#include <QFutureWatcher>
+#include <QLoggingCategory>
+#include <QProcess>
 #include <QTextStream>
+#include <QUrl>
 #include <QMap>
 #include <QRegularExpression>
+#include <QSharedPointer>
+#include <QVector>
 
 namespace Fossil {
 namespace Internal {
 
+static Q_LOGGING_CATEGORY(fossilLog, "qtc.fossil");
+
+// How often the binary is checked for having been replaced.
+static const int binaryCheckIntervalMs = 10 * 1000;
+
+// Number of paths passed to a single 'fossil changes' when re-checking dirty files.
+static const int statusBatchSize = 256;
+
+// Total length of file arguments beyond which these are passed via an arguments file.
+// Keeps well below the command line limit on Windows (32K characters).
+static const int maxFileArgumentsLength = 16 * 1024;
+
+static int argumentsLength(const QStringList &args)
+{
+    int length = 0;
+    for (const QString &arg : args)
+        length += arg.size() + 1;
+    return length;
+}
+
 // Parameter widget controlling whitespace diff mode, associated with a parameter
 class FossilDiffConfig : public VcsBase::VcsBaseEditorConfig
 {
@@ -238,37 +276,230 @@ QString FossilClient::makeVersionString(unsigned version)
                     .arg(versionPart(version));
 }
 
-FossilClient::FossilClient() : VcsBase::VcsBaseClient(new FossilSettings)
+FossilClient::FossilClient() : VcsBase::VcsBaseClient(new FossilSettings),
+    m_statusTracker(new StatusTracker(this)),
+    m_repositoryTemplatePool(new RepositoryTemplatePool(this)),
+    m_topLevelCache(new TopLevelCache(this)),
+    m_commandStatistics(new CommandStatistics(this)),
+    m_blockingDetector(new BlockingDetector(this)),
+    m_inFlightQueries(new InFlightQueries),
+    m_jobScheduler(new JobScheduler(this)),
+    m_syncProxy(new SyncProxy(this))
 {
-    setDiffConfigCreator([this](QToolBar *toolBar) {
-        return new FossilDiffConfig(this, toolBar);
+    m_syncRemotesClock.start();
+    connect(this, &VcsBase::VcsBaseClient::changed, this, [this](const QVariant &v) {
+        const QString directory = v.toString();
+        m_inFlightQueries->invalidate(directory.isEmpty() ? QString() : m_topLevelCache->topLevel(directory));
     });
 }
 
-unsigned int FossilClient::synchronousBinaryVersion() const
+void FossilClient::invalidateQueries(const QString &path)
 {
-    if (settings().binaryPath().isEmpty())
-        return 0;
+    const QFileInfo fi(path);
+    const QString directory = fi.isDir() ? fi.absoluteFilePath() : fi.absolutePath();
+    m_inFlightQueries->invalidate(m_topLevelCache->topLevel(directory));
+}
 
-    QStringList args("version");
+StatusTracker *FossilClient::statusTracker() const
+{
+    return m_statusTracker;
+}
 
-    const Utils::SynchronousProcessResponse response = vcsFullySynchronousExec(QString(), args);
-    if (response.result != Utils::SynchronousProcessResponse::Finished)
-        return 0;
+RepositoryTemplatePool *FossilClient::repositoryTemplatePool() const
+{
+    return m_repositoryTemplatePool;
+}
 
-    QString output = response.stdOut();
-    output = output.trimmed();
+TopLevelCache *FossilClient::topLevelCache() const
+{
+    return m_topLevelCache;
+}
 
-    // fossil version:
-    // "This is fossil version 1.27 [ccdefa355b] 2013-09-30 11:47:18 UTC"
-    QRegularExpression versionPattern("(\\d+)\\.(\\d+)");
-    QTC_ASSERT(versionPattern.isValid(), return 0);
-    QRegularExpressionMatch versionMatch = versionPattern.match(output);
-    QTC_ASSERT(versionMatch.hasMatch(), return 0);
-    const int major = versionMatch.captured(1).toInt();
-    const int minor = versionMatch.captured(2).toInt();
-    const int patch = 0;
-    return makeVersionNumber(major,minor,patch);
+CommandStatistics *FossilClient::commandStatistics() const
+{
+    return m_commandStatistics;
+}
+
+BlockingDetector *FossilClient::blockingDetector() const
+{
+    return m_blockingDetector;
+}
+
+JobScheduler *FossilClient::jobScheduler() const
+{
+    return m_jobScheduler;
+}
+
+SyncProxy *FossilClient::syncProxy() const
+{
+    return m_syncProxy;
+}
+
+Utils::SynchronousProcessResponse FossilClient::vcsFullySynchronousExec(
+        const QString &workingDir, const QStringList &args, unsigned flags,
+        int timeoutMultiplier, QTextCodec *codec) const
+{
+    const qint64 startUs = m_commandStatistics->nowUs();
+    const auto query = [&]() {
+        const Utils::SynchronousProcessResponse response =
+                VcsBaseClient::vcsFullySynchronousExec(workingDir, args, flags, timeoutMultiplier, codec);
+        m_blockingDetector->check(m_commandStatistics->record(
+                args.value(0), workingDir, startUs,
+                response.rawStdOut.size() + response.rawStdErr.size(),
+                response.result == Utils::SynchronousProcessResponse::Finished,
+                CommandRecord::FullySynchronous));
+        return response;
+    };
+    const QString topLevel = workingDir.isEmpty() ? QString() : m_topLevelCache->topLevel(workingDir);
+    if (!InFlightQueries::isReadOnly(args)) {
+        const Utils::SynchronousProcessResponse response = query();
+        m_inFlightQueries->invalidate(topLevel);
+        return response;
+    }
+    if (codec)
+        return query();
+
+    bool merged = false;
+    const Utils::SynchronousProcessResponse response =
+            m_inFlightQueries->run(workingDir, topLevel, args, flags, query, &merged);
+    if (merged) {
+        // Not a spawn of its own, though a wait for a running one may still have blocked.
+        m_commandStatistics->addSpawnSaved();
+        CommandRecord record;
+        record.verb = args.value(0);
+        record.workingDirectory = workingDir;
+        record.startUs = startUs;
+        record.durationUs = m_commandStatistics->nowUs() - startUs;
+        record.guiThread = CommandStatistics::isGuiThread();
+        record.exec = CommandRecord::FullySynchronous;
+        m_blockingDetector->check(record);
+        qCDebug(fossilLog) << "Merged" << args.value(0) << "into a running query in" << workingDir;
+    }
+    return response;
+}
+
+Utils::SynchronousProcessResponse FossilClient::vcsSynchronousExec(
+        const QString &workingDir, const QStringList &args, unsigned flags,
+        QTextCodec *outputCodec) const
+{
+    const qint64 startUs = m_commandStatistics->nowUs();
+    const Utils::SynchronousProcessResponse response =
+            VcsBaseClient::vcsSynchronousExec(workingDir, args, flags, outputCodec);
+    m_blockingDetector->check(m_commandStatistics->record(
+            args.value(0), workingDir, startUs,
+            response.rawStdOut.size() + response.rawStdErr.size(),
+            response.result == Utils::SynchronousProcessResponse::Finished,
+            CommandRecord::Synchronous));
+    if (!InFlightQueries::isReadOnly(args))
+        m_inFlightQueries->invalidate(workingDir.isEmpty() ? QString() : m_topLevelCache->topLevel(workingDir));
+    return response;
+}
+
+void FossilClient::enqueueJob(VcsBase::VcsCommand *cmd, const QStringList &args,
+                              JobScheduler::Priority priority, const QString &workingDirectory,
+                              Utils::ExitCodeInterpreter *interpreter) const
+{
+    const QString directory = workingDirectory.isEmpty() ? cmd->defaultWorkingDirectory()
+                                                         : workingDirectory;
+    m_commandStatistics->instrument(cmd, args.value(0), directory);
+
+    const QString topLevel = m_topLevelCache->topLevel(directory);
+    if (!InFlightQueries::isReadOnly(args)) {
+        connect(cmd, &VcsBase::VcsCommand::finished, this, [this, topLevel]() {
+            m_inFlightQueries->invalidate(topLevel);
+        });
+    }
+    m_jobScheduler->schedule(topLevel.isEmpty() ? directory : topLevel, priority, cmd,
+                             [this, cmd, args, workingDirectory, interpreter]() {
+        VcsBaseClient::enqueueJob(cmd, args, workingDirectory, interpreter);
+    });
+}
+
+void FossilClient::emitTrackedStatus(const QString &repository, JobScheduler::Priority priority)
+{
+    // Same as emitParsedStatus(), however once a checkout has been fully scanned,
+    // only re-check the files marked dirty since then.
+    // Always scans in full when not enabled or not supported by the client.
+
+    const bool tracked = settings().boolValue(FossilSettings::incrementalStatusKey)
+            && supportedFeatures().testFlag(ChangesPathFeature);
+    if (!tracked) {
+        scanStatus(repository, priority, false, StatusTracker::FileStamps());
+        return;
+    }
+
+    // The files changed outside of Qt Creator are found by their stamps,
+    // which are taken off the GUI thread.
+    auto watcher = new QFutureWatcher<StatusTracker::FileStamps>(this);
+    connect(watcher, &QFutureWatcherBase::finished, this, [this, watcher, repository, priority]() {
+        const StatusTracker::FileStamps stamps = watcher->result();
+        watcher->deleteLater();
+        m_statusTracker->markChangedFiles(repository, stamps);
+        scanStatus(repository, priority, true, stamps);
+    });
+    watcher->setFuture(Utils::runAsync(&StatusTracker::stampFiles, repository));
+}
+
+void FossilClient::scanStatus(const QString &repository, JobScheduler::Priority priority,
+                              bool tracked, const StatusTracker::FileStamps &stamps)
+{
+    const bool fullScan = !tracked || !m_statusTracker->hasBaseline(repository);
+    const QStringList dirtyFiles = tracked ? m_statusTracker->dirtyFiles(repository) : QStringList();
+
+    if (!fullScan && dirtyFiles.isEmpty()) {
+        emit parsedStatus(m_statusTracker->status(repository));
+        return;
+    }
+
+    VcsBase::VcsCommand *cmd = createCommand(repository);
+    if (fullScan) {
+        cmd->addJob(vcsBinary(), QStringList(vcsCommandString(StatusCommand)), vcsTimeoutS());
+    } else {
+        for (int i = 0; i < dirtyFiles.size(); i += statusBatchSize) {
+            QStringList args("changes");
+            args << dirtyFiles.mid(i, statusBatchSize);
+            cmd->addJob(vcsBinary(), args, vcsTimeoutS());
+        }
+    }
+
+    QSharedPointer<QList<StatusItem>> items(new QList<StatusItem>);
+    connect(cmd, &VcsBase::VcsCommand::stdOutText, this, [items](const QString &text) {
+        for (const QStringRef &line : OutputLines(text)) {
+            const StatusItem item = statusItemFromLine(line);
+            if (!item.flags.isEmpty() && !item.file.isEmpty())
+                items->append(item);
+        }
+    });
+    const quint64 scanGeneration = tracked ? m_statusTracker->beginScan(repository) : 0;
+    connect(cmd, &VcsBase::VcsCommand::finished, this, [=](bool ok) {
+        if (!tracked) {
+            if (ok)
+                emit parsedStatus(*items);
+            return;
+        }
+
+        m_statusTracker->endScan(repository);
+        if (!ok) {
+            // Possibly the paths were not accepted, retry with the full scan.
+            if (!fullScan) {
+                m_statusTracker->invalidate(repository);
+                emitTrackedStatus(repository, priority);
+            }
+            return;
+        }
+
+        if (fullScan)
+            m_statusTracker->setBaseline(repository, *items, scanGeneration, stamps);
+        else
+            m_statusTracker->updateBaseline(repository, dirtyFiles, *items, scanGeneration);
+        emit parsedStatus(m_statusTracker->status(repository));
+    });
+
+    m_commandStatistics->instrument(cmd, fullScan ? vcsCommandString(StatusCommand) : QString("changes"),
+                                    repository);
+    const QString topLevel = m_topLevelCache->topLevel(repository);
+    m_jobScheduler->schedule(topLevel.isEmpty() ? repository : topLevel, priority, cmd,
+                             [cmd]() { cmd->execute(); });
 }
 
 QList<BranchInfo> FossilClient::branchListFromOutput(const QString &output, const BranchInfo::BranchFlags defaultFlags)
@@ -276,16 +507,20 @@ QList<BranchInfo> FossilClient::branchListFromOutput(const QString &output, cons
     // Branch list format:
     // "  branch-name"
     // "* current-branch"
-    return Utils::transform(output.split('\n', QString::SkipEmptyParts), [=](const QString& l) {
-        const QString &name = l.mid(2);
-        QTC_ASSERT(!name.isEmpty(), return BranchInfo());
-        const BranchInfo::BranchFlags flags = (l.startsWith("* ") ? defaultFlags | BranchInfo::Current : defaultFlags);
-        return BranchInfo(name, flags);
-    });
+    QList<BranchInfo> branches;
+    for (const QStringRef &l : OutputLines(output)) {
+        const bool isCurrent = l.startsWith("* ");
+        const QStringRef name = l.mid(2);
+        QTC_ASSERT(!name.isEmpty(), continue);
+        const BranchInfo::BranchFlags flags = (isCurrent ? defaultFlags | BranchInfo::Current : defaultFlags);
+        branches.append(BranchInfo(name.toString(), flags));
+    }
+    return branches;
 }
 
 BranchInfo FossilClient::synchronousCurrentBranch(const QString &workingDirectory)
 {
+    const BlockingDetector::CallSite callSite("FossilClient::synchronousCurrentBranch");
     if (workingDirectory.isEmpty())
         return BranchInfo();
 
@@ -294,8 +529,7 @@ BranchInfo FossilClient::synchronousCurrentBranch(const QString &workingDirector
     if (response.result != Utils::SynchronousProcessResponse::Finished)
         return BranchInfo();
 
-    const QString output = sanitizeFossilOutput(response.stdOut());
-    BranchInfo currentBranch = Utils::findOrDefault(branchListFromOutput(output), [](const BranchInfo &b) {
+    BranchInfo currentBranch = Utils::findOrDefault(branchListFromOutput(response.stdOut()), [](const BranchInfo &b) {
         return b.isCurrent();
     });
 
@@ -305,8 +539,7 @@ BranchInfo FossilClient::synchronousCurrentBranch(const QString &workingDirector
         if (response.result != Utils::SynchronousProcessResponse::Finished)
             return BranchInfo();
 
-        const QString output = sanitizeFossilOutput(response.stdOut());
-        currentBranch = Utils::findOrDefault(branchListFromOutput(output, BranchInfo::Closed), [](const BranchInfo &b) {
+        currentBranch = Utils::findOrDefault(branchListFromOutput(response.stdOut(), BranchInfo::Closed), [](const BranchInfo &b) {
             return b.isCurrent();
         });
     }
@@ -316,6 +549,7 @@ BranchInfo FossilClient::synchronousCurrentBranch(const QString &workingDirector
 
 QList<BranchInfo> FossilClient::synchronousBranchQuery(const QString &workingDirectory)
 {
+    const BlockingDetector::CallSite callSite("FossilClient::synchronousBranchQuery");
     // Return a list of all branches, including the closed ones.
     // Sort the list by branch name.
 
@@ -327,16 +561,14 @@ QList<BranchInfo> FossilClient::synchronousBranchQuery(const QString &workingDir
     if (response.result != Utils::SynchronousProcessResponse::Finished)
         return QList<BranchInfo>();
 
-    QString output = sanitizeFossilOutput(response.stdOut());
-    QList<BranchInfo> branches = branchListFromOutput(output);
+    QList<BranchInfo> branches = branchListFromOutput(response.stdOut());
 
     // Append a list of closed branches.
     response = vcsFullySynchronousExec(workingDirectory, {"branch", "list", "--closed"});
     if (response.result != Utils::SynchronousProcessResponse::Finished)
         return QList<BranchInfo>();
 
-    output = sanitizeFossilOutput(response.stdOut());
-    branches.append(branchListFromOutput(output, BranchInfo::Closed));
+    branches.append(branchListFromOutput(response.stdOut(), BranchInfo::Closed));
 
     std::sort(branches.begin(), branches.end(),
           [](const BranchInfo &a, const BranchInfo &b) { return a.name() < b.name(); });
@@ -345,6 +577,7 @@ QList<BranchInfo> FossilClient::synchronousBranchQuery(const QString &workingDir
 
 RevisionInfo FossilClient::synchronousRevisionQuery(const QString &workingDirectory, const QString &id)
 {
+    const BlockingDetector::CallSite callSite("FossilClient::synchronousRevisionQuery");
     // Query details of the given revision/check-out id,
     // if none specified, provide information about current revision
     if (workingDirectory.isEmpty())
@@ -358,25 +591,37 @@ RevisionInfo FossilClient::synchronousRevisionQuery(const QString &workingDirect
     if (response.result != Utils::SynchronousProcessResponse::Finished)
         return RevisionInfo();
 
-    const QString output = sanitizeFossilOutput(response.stdOut());
+    return revisionInfoFromOutput(response.stdOut(), id);
+}
 
+RevisionInfo FossilClient::revisionInfoFromOutput(const QString &output, const QString &id)
+{
     QString revisionId;
     QString parentId;
 
-    const QRegularExpression idRx("([0-9a-f]{5,40})");
+    static const QRegularExpression idRx("([0-9a-f]{5,40})");
     QTC_ASSERT(idRx.isValid(), return RevisionInfo());
 
-    for (const QString &l : output.split('\n', QString::SkipEmptyParts)) {
+    // Matches in place within the output, the id must be on the line itself
+    const auto idOf = [](const QStringRef &line) {
+        QRegularExpressionMatchIterator it = idRx.globalMatch(*line.string(), line.position());
+        if (!it.hasNext())
+            return QString();
+        const QRegularExpressionMatch idMatch = it.next();
+        return idMatch.capturedEnd(1) <= line.position() + line.size() ? idMatch.captured(1)
+                                                                        : QString();
+    };
+
+    for (const QStringRef &l : OutputLines(output)) {
         if (l.startsWith("checkout: ", Qt::CaseInsensitive)
             || l.startsWith("uuid: ", Qt::CaseInsensitive)) {
-            const QRegularExpressionMatch idMatch = idRx.match(l);
-            QTC_ASSERT(idMatch.hasMatch(), return RevisionInfo());
-            revisionId = idMatch.captured(1);
+            revisionId = idOf(l);
+            QTC_ASSERT(!revisionId.isEmpty(), return RevisionInfo());
 
         } else if (l.startsWith("parent: ", Qt::CaseInsensitive)){
-            const QRegularExpressionMatch idMatch = idRx.match(l);
-            if (idMatch.hasMatch())
-                parentId = idMatch.captured(1);
+            const QString id = idOf(l);
+            if (!id.isEmpty())
+                parentId = id;
         }
     }
 
@@ -391,6 +636,7 @@ RevisionInfo FossilClient::synchronousRevisionQuery(const QString &workingDirect
 
 QStringList FossilClient::synchronousTagQuery(const QString &workingDirectory, const QString &id)
 {
+    const BlockingDetector::CallSite callSite("FossilClient::synchronousTagQuery");
     // Return a list of tags for the given revision.
     // If no revision specified, all defined tags are listed.
     // Tag list includes branch names.
@@ -407,63 +653,148 @@ QStringList FossilClient::synchronousTagQuery(const QString &workingDirectory, c
     if (response.result != Utils::SynchronousProcessResponse::Finished)
         return QStringList();
 
-    const QString output = sanitizeFossilOutput(response.stdOut());
+    QStringList tags;
+    for (const QStringRef &l : OutputLines(response.stdOut()))
+        tags.append(l.toString());
+    return tags;
+}
 
-    return output.split('\n', QString::SkipEmptyParts);
+// The properties handled by the repository settings are read from the config
+// tables in a single fossil process. Rows are ordered by precedence:
+// checkout (localdb), repository, then global (configdb). The sorted rows are
+// only printed once the whole statement ran, the end marker coming last tells
+// that it did; "fossil sql" may exit successfully having run nothing.
+static const char settingsQueryEnd[] = "3|settings-query-end|";
+static const char settingsQuerySql[] =
+        "SELECT 0, name, value FROM localdb.vvar WHERE name = 'default-user'"
+        " UNION ALL SELECT 1, name, value FROM repository.config"
+        " WHERE name IN ('default-user', 'autosync', 'ssl-identity')"
+        " UNION ALL SELECT 2, name, value FROM configdb.global_config"
+        " WHERE name IN ('autosync', 'ssl-identity')"
+        " UNION ALL SELECT 3, 'settings-query-end', ''"
+        " ORDER BY 1;";
+
+static bool autosyncFromValue(const QStringRef &value, RepositorySettings::AutosyncMode *mode)
+{
+    if (value.compare(QLatin1String("on"), Qt::CaseInsensitive) == 0
+        || value == QLatin1String("1"))
+        *mode = RepositorySettings::AutosyncOn;
+    else if (value.compare(QLatin1String("off"), Qt::CaseInsensitive) == 0
+             || value == QLatin1String("0"))
+        *mode = RepositorySettings::AutosyncOff;
+    else if (value.compare(QLatin1String("pullonly"), Qt::CaseInsensitive) == 0
+             || value == QLatin1String("2"))
+        *mode = RepositorySettings::AutosyncPullOnly;
+    else
+        return false;
+    return true;
 }
 
 RepositorySettings FossilClient::synchronousSettingsQuery(const QString &workingDirectory)
 {
+    const BlockingDetector::CallSite callSite("FossilClient::synchronousSettingsQuery");
     if (workingDirectory.isEmpty())
         return RepositorySettings();
 
     RepositorySettings repoSettings;
+    // Fossil versions without the attached config databases are asked through
+    // "user default" and "settings", and so is any other when the query failed.
+    if (!supportedFeatures().testFlag(ConfigTableFeature)
+            || !synchronousConfigTableQuery(workingDirectory, &repoSettings)) {
+        repoSettings = RepositorySettings();
+        if (!synchronousSettingsCommandQuery(workingDirectory, &repoSettings))
+            return RepositorySettings();
+    }
 
-    repoSettings.user = synchronousUserDefaultQuery(workingDirectory);
     if (repoSettings.user.isEmpty())
         repoSettings.user = settings().stringValue(FossilSettings::userNameKey);
 
+    return repoSettings;
+}
+
+void FossilClient::settingsFromSettingsOutput(const QString &output, RepositorySettings *repoSettings)
+{
+    for (const QStringRef &line : OutputLines(output)) {
+        // parse settings line:
+        // <property> <(local|global)> <value>
+        // Fossil properties are case-insensitive; compare them as such.
+        // Values may be in mixed-case; compare fixed values case-insensitive.
+        const QVector<QStringRef> fields = line.split(' ', QString::SkipEmptyParts);
+
+        const QStringRef property = fields.at(0);
+        const QStringRef value = (fields.size() >= 3 ? fields.at(2) : QStringRef());
+
+        if (property.compare(QLatin1String("autosync"), Qt::CaseInsensitive) == 0)
+            autosyncFromValue(value, &repoSettings->autosync);
+        else if (property.compare(QLatin1String("ssl-identity"), Qt::CaseInsensitive) == 0)
+            repoSettings->sslIdentityFile = value.toString();
+    }
+}
+
+bool FossilClient::synchronousConfigTableQuery(const QString &workingDirectory,
+                                               RepositorySettings *repoSettings)
+{
+    const BlockingDetector::CallSite callSite("FossilClient::synchronousConfigTableQuery");
+    const QStringList args({"sql", settingsQuerySql});
+
+    const Utils::SynchronousProcessResponse response = vcsFullySynchronousExec(workingDirectory, args);
+    if (response.result != Utils::SynchronousProcessResponse::Finished)
+        return false;
+
+    return settingsFromConfigTableOutput(response.stdOut(), repoSettings);
+}
+
+bool FossilClient::synchronousSettingsCommandQuery(const QString &workingDirectory,
+                                                   RepositorySettings *repoSettings)
+{
+    const BlockingDetector::CallSite callSite("FossilClient::synchronousSettingsCommandQuery");
+    repoSettings->user = synchronousUserDefaultQuery(workingDirectory);
+
     const QStringList args("settings");
 
     const Utils::SynchronousProcessResponse response = vcsFullySynchronousExec(workingDirectory, args);
     if (response.result != Utils::SynchronousProcessResponse::Finished)
-        return RepositorySettings();
+        return false;
 
-    const QString output = sanitizeFossilOutput(response.stdOut());
+    settingsFromSettingsOutput(response.stdOut(), repoSettings);
+    return true;
+}
 
-    for (const QString &line : output.split('\n', QString::SkipEmptyParts)) {
-        // parse settings line:
-        // <property> <(local|global)> <value>
-        // Fossil properties are case-insensitive; force them to lower-case.
-        // Values may be in mixed-case; force lower-case for fixed values.
-        const QStringList fields = line.split(' ', QString::SkipEmptyParts);
-
-        const QString property = fields.at(0).toLower();
-        const QString value = (fields.size() >= 3 ? fields.at(2) : QString());
-        const QString lcValue = value.toLower();
-
-        if (property == "autosync") {
-            if (lcValue == "on"
-                || lcValue == "1")
-                repoSettings.autosync = RepositorySettings::AutosyncOn;
-            else if (lcValue == "off"
-                     || lcValue == "0")
-                repoSettings.autosync = RepositorySettings::AutosyncOff;
-            else if (lcValue == "pullonly"
-                     || lcValue == "2")
-                repoSettings.autosync = RepositorySettings::AutosyncPullOnly;
-        }
-        else if (property == "ssl-identity") {
-            repoSettings.sslIdentityFile = value;
+bool FossilClient::settingsFromConfigTableOutput(const QString &output, RepositorySettings *repoSettings)
+{
+    // parse rows: <precedence>|<property>|<value>
+    // the first row of each property is the effective one
+    bool hasUser = false;
+    bool hasAutosync = false;
+    bool hasSslIdentity = false;
+    bool complete = false;
+    for (const QStringRef &line : OutputLines(output)) {
+        complete = (line == QLatin1String(settingsQueryEnd));
+        const QVector<QStringRef> fields = line.split('|');
+        if (fields.size() < 3)
+            continue;
+
+        const QStringRef property = fields.at(1);
+        // values may contain the separator
+        const QStringRef value = line.mid(fields.at(0).size() + property.size() + 2);
+
+        if (!hasUser && property == QLatin1String("default-user")) {
+            repoSettings->user = value.toString();
+            hasUser = true;
+        } else if (!hasAutosync && property == QLatin1String("autosync")) {
+            hasAutosync = autosyncFromValue(value, &repoSettings->autosync);
+        } else if (!hasSslIdentity && property == QLatin1String("ssl-identity")) {
+            repoSettings->sslIdentityFile = value.toString();
+            hasSslIdentity = true;
         }
     }
-
-    return repoSettings;
+    return complete;
 }
 
 bool FossilClient::synchronousSetSetting(const QString &workingDirectory,
                                          const QString &property, const QString &value, bool isGlobal)
 {
+    const BlockingDetector::CallSite callSite("FossilClient::synchronousSetSetting");
     // set a repository property to the given value
     // if no value is given, unset the property
 
@@ -480,6 +811,7 @@ bool FossilClient::synchronousSetSetting(const QString &workingDirectory,
         args << "--global";
 
     const Utils::SynchronousProcessResponse response = vcsFullySynchronousExec(workingDirectory, args);
+    invalidateSyncRemote(isGlobal ? QString() : workingDirectory);
     return (response.result == Utils::SynchronousProcessResponse::Finished);
 }
 
@@ -487,6 +819,7 @@ bool FossilClient::synchronousSetSetting(const QString &workingDirectory,
 bool FossilClient::synchronousConfigureRepository(const QString &workingDirectory, const RepositorySettings &newSettings,
                                                   const RepositorySettings &currentSettings)
 {
+    const BlockingDetector::CallSite callSite("FossilClient::synchronousConfigureRepository");
     if (workingDirectory.isEmpty())
         return false;
 
@@ -530,6 +863,7 @@ bool FossilClient::synchronousConfigureRepository(const QString &workingDirector
 
 QString FossilClient::synchronousUserDefaultQuery(const QString &workingDirectory)
 {
+    const BlockingDetector::CallSite callSite("FossilClient::synchronousUserDefaultQuery");
     if (workingDirectory.isEmpty())
         return QString();
 
@@ -539,13 +873,12 @@ QString FossilClient::synchronousUserDefaultQuery(const QString &workingDirector
     if (response.result != Utils::SynchronousProcessResponse::Finished)
         return QString();
 
-    QString output = sanitizeFossilOutput(response.stdOut());
-
-    return output.trimmed();
+    return OutputLines(response.stdOut()).firstLine();
 }
 
 bool FossilClient::synchronousSetUserDefault(const QString &workingDirectory, const QString &userName)
 {
+    const BlockingDetector::CallSite callSite("FossilClient::synchronousSetUserDefault");
     if (workingDirectory.isEmpty() || userName.isEmpty())
         return false;
 
@@ -557,6 +890,7 @@ bool FossilClient::synchronousSetUserDefault(const QString &workingDirectory, co
 
 QString FossilClient::synchronousGetRepositoryURL(const QString &workingDirectory)
 {
+    const BlockingDetector::CallSite callSite("FossilClient::synchronousGetRepositoryURL");
     if (workingDirectory.isEmpty())
         return QString();
 
@@ -566,11 +900,10 @@ QString FossilClient::synchronousGetRepositoryURL(const QString &workingDirector
     if (response.result != Utils::SynchronousProcessResponse::Finished)
         return QString();
 
-    QString output = sanitizeFossilOutput(response.stdOut());
-    output = output.trimmed();
+    const QString output = OutputLines(response.stdOut()).firstLine();
 
     // Fossil returns "off" when no remote-url is set.
-    if (output.isEmpty() || output.toLower() == "off")
+    if (output.isEmpty() || output.compare("off", Qt::CaseInsensitive) == 0)
         return QString();
 
     return output;
@@ -578,20 +911,60 @@ QString FossilClient::synchronousGetRepositoryURL(const QString &workingDirector
 
 QString FossilClient::synchronousTopic(const QString &workingDirectory)
 {
+    const BlockingDetector::CallSite callSite("FossilClient::synchronousTopic");
     if (workingDirectory.isEmpty())
         return QString();
 
-    // return current branch name
+    // return current branch name;
+    // look up the branch tag of the checked out version directly in the checkout
+    // and repository databases, instead of listing the open and closed branches.
+    // The end marker sorted last tells that the statement ran, the version may
+    // legitimately have no branch tag.
+
+    static const char currentBranchSql[] =
+            "SELECT 0, value FROM repository.tagxref"
+            " WHERE rid = (SELECT value FROM localdb.vvar WHERE name = 'checkout')"
+            " AND tagid = (SELECT tagid FROM repository.tag WHERE tagname = 'branch')"
+            " AND tagtype > 0"
+            " UNION ALL SELECT 1, 'topic-query-end'"
+            " ORDER BY 1;";
+
+    QElapsedTimer timer;
+    timer.start();
+
+    QString topic;
+    bool probed = false;
+    const Utils::SynchronousProcessResponse response =
+            vcsFullySynchronousExec(workingDirectory, {"sql", currentBranchSql});
+    if (response.result == Utils::SynchronousProcessResponse::Finished)
+        probed = topicFromOutput(response.stdOut(), &topic);
+
+    if (!probed) {
+        // Fossil versions without the attached checkout database
+        topic = synchronousCurrentBranch(workingDirectory).name();
+    }
 
-    const BranchInfo branchInfo = synchronousCurrentBranch(workingDirectory);
-    if (branchInfo.name().isEmpty())
-        return QString();
+    qCDebug(fossilLog) << "Topic of" << workingDirectory << "is" << topic
+                       << (probed ? "(probed)" : "(from branch list)")
+                       << "in" << timer.elapsed() << "ms";
+    return topic;
+}
 
-    return branchInfo.name();
+bool FossilClient::topicFromOutput(const QString &output, QString *topic)
+{
+    // parse rows: 0|<branch name>, then the end marker
+    bool complete = false;
+    for (const QStringRef &line : OutputLines(output)) {
+        complete = (line == QLatin1String("1|topic-query-end"));
+        if (line.startsWith(QLatin1String("0|")))
+            *topic = line.mid(2).toString();
+    }
+    return complete;
 }
 
 bool FossilClient::synchronousCreateRepository(const QString &workingDirectory, const QStringList &extraOptions)
 {
+    const BlockingDetector::CallSite callSite("FossilClient::synchronousCreateRepository");
     VcsBase::VcsOutputWindow *outputWindow = VcsBase::VcsOutputWindow::instance();
 
     // init repository file of the same name as the working directory
@@ -608,58 +981,111 @@ bool FossilClient::synchronousCreateRepository(const QString &workingDirectory,
     // @TODO: handle spaces in the path
     // @TODO: what about --template options?
 
+    QElapsedTimer timer;
+    timer.start();
+
     const Utils::FileName repoFilePath = Utils::FileName::fromString(repoPath)
             .appendPath(Utils::FileName::fromString(repoName, Constants::FOSSIL_FILE_SUFFIX).toString());
-    QStringList args(vcsCommandString(CreateRepositoryCommand));
-    if (!adminUser.isEmpty())
-        args << "--admin-user" << adminUser;
-    args << extraOptions << repoFilePath.toUserOutput();
-    Utils::SynchronousProcessResponse response = vcsFullySynchronousExec(workingDirectory, args);
-    if (response.result != Utils::SynchronousProcessResponse::Finished)
-        return false;
-
-    QString output = sanitizeFossilOutput(response.stdOut());
-    outputWindow->append(output);
-
-    // check out the created repository file into the working directory
-
-    args.clear();
-    response.clear();
-    output.clear();
-
-    args << "open" << repoFilePath.toUserOutput();
-    response = vcsFullySynchronousExec(workingDirectory, args);
-    if (response.result != Utils::SynchronousProcessResponse::Finished)
-        return false;
 
-    output = sanitizeFossilOutput(response.stdOut());
-    outputWindow->append(output);
-
-    // set user default to admin if specified
-
-    if (!adminUser.isEmpty()) {
-        args.clear();
-        response.clear();
-        output.clear();
-
-        args << "user" << "default" << adminUser << "--user" << adminUser;
+    // A pre-created template stands in for "fossil new" unless
+    // specific creation options are requested
+    const bool fromTemplate = (extraOptions.isEmpty()
+                               && m_repositoryTemplatePool->takeTemplate(repoFilePath.toString()));
+    QStringList args;
+    Utils::SynchronousProcessResponse response;
+    QString output;
+    if (!fromTemplate) {
+        args << vcsCommandString(CreateRepositoryCommand);
+        if (!adminUser.isEmpty())
+            args << "--admin-user" << adminUser;
+        args << extraOptions << repoFilePath.toUserOutput();
         response = vcsFullySynchronousExec(workingDirectory, args);
         if (response.result != Utils::SynchronousProcessResponse::Finished)
             return false;
 
-        QString output = sanitizeFossilOutput(response.stdOut());
+        output = sanitizeFossilOutput(response.stdOut());
         outputWindow->append(output);
     }
 
-    resetCachedVcsInfo(workingDirectory);
+    // check out the created repository file into the working directory
+    // and set user default to admin if specified. These run in the background,
+    // the files added to the checkout meanwhile are added once it is open.
+
+    const QString checkout = QDir(workingDirectory).absolutePath();
+    VcsBase::VcsCommand *cmd = createCommand(checkout);
+    cmd->addJob(vcsBinary(), {"open", repoFilePath.toUserOutput()}, vcsTimeoutS());
+    if (!adminUser.isEmpty())
+        cmd->addJob(vcsBinary(), {"user", "default", adminUser, "--user", adminUser}, vcsTimeoutS());
+    m_openingCheckouts.insert(checkout, QStringList());
+
+    const qint64 createdMs = timer.elapsed();
+    connect(cmd, &VcsBase::VcsCommand::finished, this, [=](bool ok) {
+        const QStringList addedFiles = m_openingCheckouts.take(checkout);
+        m_topLevelCache->invalidate(checkout);
+        resetCachedVcsInfo(checkout);
+        if (!ok)
+            return;
+
+        VcsBase::VcsOutputWindow::appendSilently(
+                    tr("Repository %1 created %2 in %3 ms, opened in %4 ms.")
+                    .arg(repoFilePath.toUserOutput())
+                    .arg(fromTemplate ? tr("from a template") : tr("with \"fossil new\""))
+                    .arg(createdMs).arg(timer.elapsed()));
+
+        if (!addedFiles.isEmpty()) {
+            QStringList addArgs(vcsCommandString(AddCommand));
+            addArgs << addedFiles;
+            enqueueJob(createCommand(checkout), addArgs, JobScheduler::Normal);
+        }
+    });
 
+    m_commandStatistics->instrument(cmd, "open", checkout);
+    m_jobScheduler->schedule(checkout, JobScheduler::Interactive, cmd, [cmd]() { cmd->execute(); });
     return true;
 }
 
+bool FossilClient::addWhenOpened(const QString &workingDir, const QString &fileName)
+{
+    // Files added to a checkout that is still being opened after its creation,
+    // as the new project wizards do right after creating the repository.
+    const QString directory = QDir(workingDir).absolutePath();
+    for (auto it = m_openingCheckouts.begin(), end = m_openingCheckouts.end(); it != end; ++it) {
+        if (directory == it.key() || directory.startsWith(it.key() + '/')) {
+            it.value().append(QDir(it.key()).relativeFilePath(directory + '/' + fileName));
+            return true;
+        }
+    }
+    return false;
+}
+
+bool FossilClient::synchronousAdd(const QString &workingDir, const QString &fileName,
+                                  const QStringList &extraOptions)
+{
+    // Same as VcsBaseClient::synchronousAdd(), however run through this client's
+    // vcsFullySynchronousExec(), which drops the query results kept for the checkout.
+    const BlockingDetector::CallSite callSite("FossilClient::synchronousAdd");
+    QStringList args(vcsCommandString(AddCommand));
+    args << extraOptions << fileName;
+    const Utils::SynchronousProcessResponse response = vcsFullySynchronousExec(workingDir, args);
+    return (response.result == Utils::SynchronousProcessResponse::Finished);
+}
+
+bool FossilClient::synchronousRemove(const QString &workingDir, const QString &fileName,
+                                     const QStringList &extraOptions)
+{
+    // Same as VcsBaseClient::synchronousRemove(), see synchronousAdd()
+    const BlockingDetector::CallSite callSite("FossilClient::synchronousRemove");
+    QStringList args(vcsCommandString(RemoveCommand));
+    args << extraOptions << fileName;
+    const Utils::SynchronousProcessResponse response = vcsFullySynchronousExec(workingDir, args);
+    return (response.result == Utils::SynchronousProcessResponse::Finished);
+}
+
 bool FossilClient::synchronousMove(const QString &workingDir,
                                    const QString &from, const QString &to,
                                    const QStringList &extraOptions)
 {
+    const BlockingDetector::CallSite callSite("FossilClient::synchronousMove");
     // Fossil move does not rename actual file on disk, only changes it in repo
     // So try to move the actual file first, then move it in repo to preserve
     // history in case actual move fails.
@@ -673,48 +1099,252 @@ bool FossilClient::synchronousMove(const QString &workingDir,
     return (response.result == Utils::SynchronousProcessResponse::Finished);
 }
 
-bool FossilClient::synchronousPull(const QString &workingDir, const QString &srcLocation, const QStringList &extraOptions)
+void FossilClient::pull(const QString &workingDir, const QString &srcLocation, const QStringList &extraOptions)
 {
-    const QString remoteLocation = (!srcLocation.isEmpty() ? srcLocation : synchronousGetRepositoryURL(workingDir));
-    if (remoteLocation.isEmpty())
-        return false;
+    // Without a location fossil pulls from the remote remembered by the repository.
+    sync(PullCommand, workingDir, srcLocation, extraOptions);
+}
 
-    QStringList args({vcsCommandString(PullCommand), remoteLocation});
-    args << extraOptions;
+void FossilClient::push(const QString &workingDir, const QString &dstLocation, const QStringList &extraOptions)
+{
+    // Without a location fossil pushes to the remote remembered by the repository.
+    sync(PushCommand, workingDir, dstLocation, extraOptions);
+}
+
+void FossilClient::sync(VcsCommandTag cmd, const QString &workingDir, const QString &remoteLocation,
+                        const QStringList &extraOptions)
+{
+    const QString verb = vcsCommandString(cmd);
+    const QStringList args = syncArguments(workingDir, verb, remoteLocation, extraOptions);
+
+    QSharedPointer<SyncProgress> progress(new SyncProgress);
+    VcsBase::VcsCommand *command = createSyncCommand(workingDir, progress);
     // Disable UNIX terminals to suppress SSH prompting
-    const unsigned flags =
-            VcsBase::VcsCommand::SshPasswordPrompt
-            | VcsBase::VcsCommand::ShowStdOut
-            | VcsBase::VcsCommand::ShowSuccessMessage;
-    const Utils::SynchronousProcessResponse resp = vcsSynchronousExec(workingDir, args, flags);
-    const bool success = (resp.result == Utils::SynchronousProcessResponse::Finished);
-    if (success)
-        emit changed(QVariant(workingDir));
-    return success;
+    command->addFlags(VcsBase::VcsCommand::SshPasswordPrompt
+                      | VcsBase::VcsCommand::ShowStdOut
+                      | VcsBase::VcsCommand::ShowSuccessMessage);
+
+    QSharedPointer<QElapsedTimer> timer(new QElapsedTimer);
+    timer->start();
+    connect(command, &VcsBase::VcsCommand::finished, this,
+            [this, cmd, verb, workingDir, progress, timer](bool ok) {
+        const qint64 elapsedMs = qMax<qint64>(timer->elapsed(), 1);
+        const SyncStatistics stats = progress->statistics();
+        const qint64 bytes = stats.bytesSent + stats.bytesReceived;
+        VcsBase::VcsOutputWindow::appendSilently(
+                    tr("%1 %2: %3 round-trips, %4 artifacts sent, %5 received, "
+                       "%6 bytes sent, %7 received in %8 s (%9 KB/s).")
+                    .arg(verb)
+                    .arg(ok ? tr("finished") : tr("failed"))
+                    .arg(stats.roundTrips)
+                    .arg(stats.artifactsSent)
+                    .arg(stats.artifactsReceived)
+                    .arg(stats.bytesSent)
+                    .arg(stats.bytesReceived)
+                    .arg(elapsedMs / 1000.0, 0, 'f', 1)
+                    .arg(bytes * 1000.0 / 1024.0 / elapsedMs, 0, 'f', 1));
+
+        if (ok && cmd == PullCommand)
+            emit changed(QVariant(workingDir));
+    });
+
+    enqueueJob(command, args, JobScheduler::Normal);
 }
 
-bool FossilClient::synchronousPush(const QString &workingDir, const QString &dstLocation, const QStringList &extraOptions)
+VcsBase::VcsCommand *FossilClient::createSyncCommand(const QString &workingDir,
+                                                     const QSharedPointer<SyncProgress> &progress)
 {
-    const QString remoteLocation = (!dstLocation.isEmpty() ? dstLocation : synchronousGetRepositoryURL(workingDir));
-    if (remoteLocation.isEmpty())
-        return false;
+    VcsBase::VcsCommand *command = createCommand(workingDir);
+    // The transfer counters are parsed in the command's thread, the statistics
+    // outlive the command which gets deleted once it is done.
+    command->setProgressParser(new SyncProgressParser(progress));
+    return command;
+}
 
-    QStringList args({vcsCommandString(PushCommand), remoteLocation});
+QStringList FossilClient::syncArguments(const QString &workingDir, const QString &verb,
+                                        const QString &remoteLocation, const QStringList &extraOptions)
+{
+    // Without a location fossil syncs with the remote remembered by the repository.
+    // With the sync proxy enabled, that remote is reached through its local URL
+    // just this once (--once), so that the repository keeps remembering the remote
+    // itself. A sync that is to remember a new location is not relayed.
+
+    QString location = remoteLocation;
+    bool relayed = false;
+    const bool once = remoteLocation.isEmpty() || extraOptions.contains("--once");
+    if (!once) {
+        invalidateSyncRemote(workingDir);
+    } else if (settings().boolValue(FossilSettings::syncProxyKey)) {
+        const SyncRemote &remote = syncRemote(workingDir);
+        const QString remoteUrl = remoteLocation.isEmpty() ? remote.url : remoteLocation;
+        if (!remoteUrl.isEmpty() && canRelay(remote, QUrl(remoteUrl))) {
+            const QString localUrl = m_syncProxy->localUrl(remoteUrl);
+            if (localUrl != remoteUrl) {
+                location = localUrl;
+                relayed = true;
+            }
+        }
+    }
+
+    QStringList args(verb);
+    if (!location.isEmpty())
+        args << location;
     args << extraOptions;
-    // Disable UNIX terminals to suppress SSH prompting
-    const unsigned flags =
-            VcsBase::VcsCommand::SshPasswordPrompt
-            | VcsBase::VcsCommand::ShowStdOut
-            | VcsBase::VcsCommand::ShowSuccessMessage;
-    const Utils::SynchronousProcessResponse resp = vcsSynchronousExec(workingDir, args, flags);
-    return (resp.result == Utils::SynchronousProcessResponse::Finished);
+    if (relayed && !extraOptions.contains("--once"))
+        args << "--once";
+    return args;
+}
+
+// The settings under which fossil reaches a remote other than the relay does:
+// with a client certificate, through a proxy, trusting its own certificate
+// authorities, or trusting server certificates the user accepted (global only).
+// Certificates span several lines, only their names are printed.
+static const char relayQueryEnd[] = "3|relay-query-end|";
+static const char relayQuerySql[] =
+        "SELECT 1, name, value FROM repository.config"
+        " WHERE name IN ('ssl-identity', 'ssl-ca-location', 'proxy')"
+        " UNION ALL SELECT 2, name, value FROM configdb.global_config"
+        " WHERE name IN ('ssl-identity', 'ssl-ca-location', 'proxy')"
+        " UNION ALL SELECT 2, name, '' FROM configdb.global_config"
+        " WHERE name LIKE 'cert:%' OR name LIKE 'trusted:%'"
+        " UNION ALL SELECT 3, 'relay-query-end', ''"
+        " ORDER BY 1;";
+
+static const int syncRemoteTtlMs = 5 * 60 * 1000;
+
+const FossilClient::SyncRemote &FossilClient::syncRemote(const QString &workingDir)
+{
+    const QString topLevel = m_topLevelCache->topLevel(workingDir);
+    const QString key = topLevel.isEmpty() ? workingDir : topLevel;
+    const qint64 now = m_syncRemotesClock.elapsed();
+    const auto it = m_syncRemotes.constFind(key);
+    if (it != m_syncRemotes.constEnd() && it->expiresMs > now)
+        return *it;
+
+    const BlockingDetector::CallSite callSite("FossilClient::syncRemote");
+    SyncRemote remote;
+    remote.url = synchronousGetRepositoryURL(workingDir);
+    const Utils::SynchronousProcessResponse response =
+            vcsFullySynchronousExec(workingDir, {"sql", relayQuerySql});
+    remote.settingsKnown = response.result == Utils::SynchronousProcessResponse::Finished
+            && relaySettingsFromOutput(response.stdOut(), &remote);
+    remote.expiresMs = now + syncRemoteTtlMs;
+    return *m_syncRemotes.insert(key, remote);
+}
+
+void FossilClient::invalidateSyncRemote(const QString &workingDir)
+{
+    if (workingDir.isEmpty()) {
+        m_syncRemotes.clear();
+        return;
+    }
+    const QString topLevel = m_topLevelCache->topLevel(workingDir);
+    m_syncRemotes.remove(topLevel.isEmpty() ? workingDir : topLevel);
+}
+
+bool FossilClient::relaySettingsFromOutput(const QString &output, SyncRemote *remote)
+{
+    // parse rows: <precedence>|<property>|<value>
+    // the first row of each property is the effective one
+    QStringList known;
+    bool complete = false;
+    for (const QStringRef &line : OutputLines(output)) {
+        complete = (line == QLatin1String(relayQueryEnd));
+        const QVector<QStringRef> fields = line.split('|');
+        if (fields.size() < 3)
+            continue;
+
+        const QString property = fields.at(1).toString();
+        const QString value = line.mid(fields.at(0).size() + property.size() + 2).toString().trimmed();
+
+        const int colon = property.indexOf(':');
+        if (colon > 0) {
+            remote->acceptedCertificateHosts << property.mid(colon + 1).toLower();
+            continue;
+        }
+        if (known.contains(property))
+            continue;
+        known << property;
+        if (property == "ssl-identity")
+            remote->sslIdentity = value;
+        else if (property == "ssl-ca-location")
+            remote->sslCaLocation = value;
+        else if (property == "proxy")
+            remote->proxy = value;
+    }
+    return complete;
+}
+
+bool FossilClient::canRelay(const SyncRemote &remote, const QUrl &url) const
+{
+    // The relay connects directly and verifies servers against the system's
+    // certificate authorities only; when fossil is set up otherwise, its own
+    // connection is the one that works.
+    if (!remote.settingsKnown || !remote.sslIdentity.isEmpty())
+        return false;
+
+    static const QStringList off = {"", "off", "no", "false", "0"};
+    QString proxy = remote.proxy;
+    if (off.contains(proxy, Qt::CaseInsensitive))
+        proxy = processEnvironment().value("http_proxy");
+    if (!off.contains(proxy, Qt::CaseInsensitive))
+        return false;
+
+    if (url.scheme().compare("https", Qt::CaseInsensitive) == 0
+            && (!remote.sslCaLocation.isEmpty()
+                || remote.acceptedCertificateHosts.contains(url.host().toLower()))) {
+        return false;
+    }
+    return SyncProxy::canRelay(url);
 }
 
 void FossilClient::commit(const QString &repositoryRoot, const QStringList &files,
                           const QString &commitMessageFile, const QStringList &extraOptions)
 {
-    VcsBaseClient::commit(repositoryRoot, files, commitMessageFile,
-                          QStringList(extraOptions) << "-M" << commitMessageFile);
+    m_statusTracker->invalidate(repositoryRoot);
+
+    QStringList args(vcsCommandString(CommitCommand));
+    args << extraOptions << "-M" << commitMessageFile;
+
+    // Large file sets would exceed the command line length limit,
+    // pass these via an arguments file (one argument per line) instead.
+    QString argsFile;
+    if (argumentsLength(files) > maxFileArgumentsLength) {
+        Utils::TempFileSaver saver;
+        saver.setAutoRemove(false);
+        saver.write(argumentsFileContents(files));
+        if (!saver.finalize()) {
+            VcsBase::VcsOutputWindow::appendError(saver.errorString());
+            return;
+        }
+        argsFile = saver.fileName();
+        args << "--args" << argsFile;
+    } else {
+        args << files;
+    }
+
+    VcsBase::VcsCommand *cmd = createCommand(repositoryRoot, nullptr, VcsWindowOutputBind);
+    connect(cmd, &VcsBase::VcsCommand::finished, [commitMessageFile, argsFile]() {
+        if (!commitMessageFile.isEmpty())
+            QFile::remove(commitMessageFile);
+        if (!argsFile.isEmpty())
+            QFile::remove(argsFile);
+    });
+    enqueueJob(cmd, args, JobScheduler::Normal);
+}
+
+QByteArray FossilClient::argumentsFileContents(const QStringList &files)
+{
+    // One argument per line. A file name starting with '-' would be taken
+    // for an option, so it is passed as relative to the current directory.
+    QByteArray contents;
+    for (const QString &file : files) {
+        if (file.startsWith('-'))
+            contents += "./";
+        contents += file.toUtf8();
+        contents += '\n';
+    }
+    return contents;
 }
 
 VcsBase::VcsBaseEditorWidget *FossilClient::annotate(
@@ -761,7 +1391,7 @@ VcsBase::VcsBaseEditorWidget *FossilClient::annotate(
     if (VcsBase::VcsBaseEditorConfig *editorConfig = fossilEditor->configurationWidget())
         effectiveArgs = editorConfig->arguments();
 
-    VcsBase::VcsCommand *cmd = createCommand(workingDir, fossilEditor);
+    VcsBase::VcsCommand *cmd = createEditorCommand(workingDir, fossilEditor);
 
     // here we introduce a "|BLAME|" meta-option to allow both annotate and blame modes
     int pos = effectiveArgs.indexOf("|BLAME|");
@@ -777,25 +1407,22 @@ VcsBase::VcsBaseEditorWidget *FossilClient::annotate(
         lineNumber = -1;
     cmd->setCookie(lineNumber);
 
-    enqueueJob(cmd, args);
+    enqueueJob(cmd, args, JobScheduler::Interactive);
     return fossilEditor;
 }
 
 bool FossilClient::isVcsFileOrDirectory(const Utils::FileName &fileName) const
 {
-    // true for any dir or file other than fossil checkout db-file
-    return !(fileName.toFileInfo().isFile()
-             && fileName.fileName().compare(Constants::FOSSILREPO, Utils::HostOsInfo::fileNameCaseSensitivity()));
+    // true for any dir or file other than fossil checkout db-file;
+    // decide by name first, the file type is looked up in the cache
+    if (fileName.fileName().compare(Constants::FOSSILREPO, Utils::HostOsInfo::fileNameCaseSensitivity()) == 0)
+        return true;
+    return !m_topLevelCache->isFile(fileName.toString());
 }
 
 QString FossilClient::findTopLevelForFile(const QFileInfo &file) const
 {
-    const QString repositoryCheckFile = Constants::FOSSILREPO;
-    return file.isDir() ?
-                VcsBase::VcsBasePlugin::findRepositoryForDirectory(file.absoluteFilePath(),
-                                                                   repositoryCheckFile) :
-                VcsBase::VcsBasePlugin::findRepositoryForDirectory(file.absolutePath(),
-                                                                   repositoryCheckFile);
+    return m_topLevelCache->topLevel(file.isDir() ? file.absoluteFilePath() : file.absolutePath());
 }
 
 bool FossilClient::managesFile(const QString &workingDirectory, const QString &fileName) const
@@ -804,32 +1431,96 @@ bool FossilClient::managesFile(const QString &workingDirectory, const QString &f
     const Utils::SynchronousProcessResponse response = vcsFullySynchronousExec(workingDirectory, args);
     if (response.result != Utils::SynchronousProcessResponse::Finished)
         return false;
-    QString output = sanitizeFossilOutput(response.stdOut());
-    return !output.startsWith("no history for file", Qt::CaseInsensitive);
+    return !response.stdOut().startsWith("no history for file", Qt::CaseInsensitive);
 }
 
-unsigned int FossilClient::binaryVersion() const
+const BinaryCapabilities &FossilClient::binaryCapabilities() const
 {
-    static unsigned int cachedBinaryVersion = 0;
-    static QString cachedBinaryPath;
+    static const BinaryCapabilities noCapabilities;
 
     const QString currentBinaryPath = settings().binaryPath().toString();
-
     if (currentBinaryPath.isEmpty())
-        return 0;
+        return noCapabilities;
+
+    // Re-check the binary itself only now and then
+    if (m_binaryCapabilities.isValid()
+        && m_binaryCapabilities.binaryPath == currentBinaryPath
+        && m_binaryCapabilitiesChecked.isValid()
+        && m_binaryCapabilitiesChecked.elapsed() < binaryCheckIntervalMs) {
+        return m_binaryCapabilities;
+    }
+    m_binaryCapabilitiesChecked.start();
+
+    const QFileInfo binary(currentBinaryPath);
+    if (m_binaryCapabilities.isValid() && m_binaryCapabilities.matches(binary))
+        return m_binaryCapabilities;
+
+    // A binary known from a previous session: use its record right away
+    // and verify it in the background.
+    const BinaryCapabilities stored = BinaryCapabilities::load(Core::ICore::settings(), binary);
+    if (stored.isValid()) {
+        m_binaryCapabilities = stored;
+        reprobeBinaryCapabilities();
+        return m_binaryCapabilities;
+    }
 
+    // A new or replaced binary needs probing before it can be used.
+    const BlockingDetector::CallSite callSite("FossilClient::binaryCapabilities");
     // Invalidate cache on failed version result.
     // Assume that fossil client options have been changed and will change again.
-    if (!cachedBinaryVersion
-        || currentBinaryPath != cachedBinaryPath) {
-        cachedBinaryVersion = synchronousBinaryVersion();
-        if (cachedBinaryVersion)
-            cachedBinaryPath = currentBinaryPath;
-        else
-            cachedBinaryPath.clear();
+    Utils::SynchronousProcessResponse response = vcsFullySynchronousExec(QString(), {"version", "-v"});
+    if (response.result != Utils::SynchronousProcessResponse::Finished) {
+        // Older versions do not know about verbose version information
+        response = vcsFullySynchronousExec(QString(), {"version"});
     }
+    if (response.result == Utils::SynchronousProcessResponse::Finished)
+        m_binaryCapabilities = BinaryCapabilities::fromVersionOutput(binary, response.stdOut());
+    else
+        m_binaryCapabilities = BinaryCapabilities();
+    m_binaryCapabilities.save(Core::ICore::settings());
+
+    return m_binaryCapabilities;
+}
 
-    return cachedBinaryVersion;
+void FossilClient::reprobeBinaryCapabilities() const
+{
+    if (m_reprobingBinaryCapabilities)
+        return;
+    m_reprobingBinaryCapabilities = true;
+
+    const QFileInfo binary(m_binaryCapabilities.binaryPath);
+    auto process = new QProcess(const_cast<FossilClient *>(this));
+    process->setProcessEnvironment(processEnvironment());
+    connect(process, static_cast<void (QProcess::*)(int, QProcess::ExitStatus)>(&QProcess::finished),
+            this, [this, process, binary](int exitCode, QProcess::ExitStatus exitStatus) {
+        m_reprobingBinaryCapabilities = false;
+        process->deleteLater();
+        if (exitStatus != QProcess::NormalExit || exitCode != 0)
+            return;
+
+        const BinaryCapabilities probed = BinaryCapabilities::fromVersionOutput(
+                    binary, QString::fromLocal8Bit(process->readAllStandardOutput()));
+        if (!probed.isValid() || probed == m_binaryCapabilities)
+            return;
+        // Not worth remembering a binary that is no longer configured
+        if (QFileInfo(settings().binaryPath().toString()).absoluteFilePath() != binary.absoluteFilePath())
+            return;
+        if (m_binaryCapabilities.binaryPath == probed.binaryPath)
+            m_binaryCapabilities = probed;
+        probed.save(Core::ICore::settings());
+    });
+    connect(process, &QProcess::errorOccurred, this, [this, process](QProcess::ProcessError error) {
+        if (error != QProcess::FailedToStart)
+            return;
+        m_reprobingBinaryCapabilities = false;
+        process->deleteLater();
+    });
+    process->start(binary.absoluteFilePath(), {"version", "-v"});
+}
+
+unsigned int FossilClient::binaryVersion() const
+{
+    return binaryCapabilities().version;
 }
 
 QString FossilClient::binaryVersionString() const
@@ -842,27 +1533,37 @@ QString FossilClient::binaryVersionString() const
     return makeVersionString(version);
 }
 
-FossilClient::SupportedFeatures FossilClient::supportedFeatures() const
+FossilClient::SupportedFeatures FossilClient::featuresForVersion(unsigned version)
 {
-    // use for legacy client support to test for feature presence
-    // e.g. supportedFeatures().testFlag(TimelineWidthFeature)
-
     SupportedFeatures features = AllSupportedFeatures; // all inclusive by default (~0U)
 
-    const unsigned int version = binaryVersion();
-
-    if (version < 0x13000) {
-        features &= ~TimelinePathFeature;
-        if (version < 0x12900)
-            features &= ~DiffIgnoreWhiteSpaceFeature;
-        if (version < 0x12800) {
-            features &= ~AnnotateBlameFeature;
-            features &= ~TimelineWidthFeature;
+    if (version < 0x20000) {
+        features &= ~ChangesPathFeature;
+        features &= ~ConfigTableFeature;
+        if (version < 0x13000) {
+            features &= ~TimelinePathFeature;
+            if (version < 0x12900)
+                features &= ~DiffIgnoreWhiteSpaceFeature;
+            if (version < 0x12800) {
+                features &= ~AnnotateBlameFeature;
+                features &= ~TimelineWidthFeature;
+            }
         }
     }
     return features;
 }
 
+FossilClient::SupportedFeatures FossilClient::supportedFeatures() const
+{
+    // use for legacy client support to test for feature presence
+    // e.g. supportedFeatures().testFlag(TimelineWidthFeature)
+
+    const BinaryCapabilities &capabilities = binaryCapabilities();
+    if (!capabilities.isValid())
+        return featuresForVersion(0);
+    return SupportedFeatures(capabilities.features);
+}
+
 void FossilClient::view(const QString &source, const QString &id, const QStringList &extraOptions)
 {
     QStringList args("diff");
@@ -884,52 +1585,44 @@ void FossilClient::view(const QString &source, const QString &id, const QStringL
                                                            VcsBase::VcsBaseEditor::getCodec(source), "view", id);
     editor->setWorkingDirectory(workingDirectory);
 
-    enqueueJob(createCommand(workingDirectory, editor), args);
-}
-
-class FossilLogHighlighter : QSyntaxHighlighter
-{
-public:
-    explicit FossilLogHighlighter(QTextDocument *parent);
-    virtual void highlightBlock(const QString &text) final;
-
-private:
-    const QRegularExpression m_revisionIdRx;
-    const QRegularExpression m_dateRx;
-};
-
-FossilLogHighlighter::FossilLogHighlighter(QTextDocument * parent) :
-    QSyntaxHighlighter(parent),
-    m_revisionIdRx(Constants::CHANGESET_ID),
-    m_dateRx("([0-9]{4}-[0-9]{2}-[0-9]{2})")
-{
-    QTC_CHECK(m_revisionIdRx.isValid());
-    QTC_CHECK(m_dateRx.isValid());
+    enqueueJob(createEditorCommand(workingDirectory, editor), args, JobScheduler::Interactive);
 }
 
-void FossilLogHighlighter::highlightBlock(const QString &text)
+void FossilClient::diff(const QString &workingDir, const QStringList &files,
+                        const QStringList &extraOptions)
 {
-    // Match the revision-ids and dates -- highlight them for convenience.
+    // Same as VcsBaseClient::diff(), however a re-run from the configuration
+    // widget supersedes the diff still running in the editor.
 
-    // Format revision-ids
-    QRegularExpressionMatchIterator i = m_revisionIdRx.globalMatch(text);
-    while (i.hasNext()) {
-        const QRegularExpressionMatch revisionIdMatch = i.next();
-        QTextCharFormat charFormat = format(0);
-        charFormat.setForeground(Qt::darkBlue);
-        //charFormat.setFontItalic(true);
-        setFormat(revisionIdMatch.capturedStart(0), revisionIdMatch.capturedLength(0), charFormat);
+    const QString vcsCmdString = vcsCommandString(DiffCommand);
+    const Core::Id kind = vcsEditorKind(DiffCommand);
+    const QString id = VcsBase::VcsBaseEditor::getTitleId(workingDir, files);
+    const QString title = vcsEditorTitle(vcsCmdString, id);
+    const QString source = VcsBase::VcsBaseEditor::getSource(workingDir, files);
+    VcsBase::VcsBaseEditorWidget *editor = createVcsEditor(kind, title, source,
+                                                           VcsBase::VcsBaseEditor::getCodec(source),
+                                                           vcsCmdString.toLatin1().constData(), id);
+    editor->setWorkingDirectory(workingDir);
+
+    VcsBase::VcsBaseEditorConfig *editorConfig = editor->editorConfig();
+    if (!editorConfig) {
+        editorConfig = new FossilDiffConfig(this, editor->toolBar());
+        editorConfig->setBaseArguments(extraOptions);
+        // editor has been just created, createVcsEditor() didn't set a configuration widget yet
+        connect(editor, &VcsBase::VcsBaseEditorWidget::diffChunkReverted,
+                editorConfig, &VcsBase::VcsBaseEditorConfig::executeCommand);
+        connect(editorConfig, &VcsBase::VcsBaseEditorConfig::commandExecutionRequested,
+            [=]() { this->diff(workingDir, files, extraOptions); } );
+        editor->setEditorConfig(editorConfig);
     }
 
-    // Format dates
-    i = m_dateRx.globalMatch(text);
-    while (i.hasNext()) {
-        const QRegularExpressionMatch dateMatch = i.next();
-        QTextCharFormat charFormat = format(0);
-        charFormat.setForeground(Qt::darkBlue);
-        charFormat.setFontWeight(QFont::DemiBold);
-        setFormat(dateMatch.capturedStart(0), dateMatch.capturedLength(0), charFormat);
-    }
+    QStringList args(vcsCmdString);
+    args << editorConfig->arguments() << files;
+
+    VcsBase::VcsCommand *cmd = createEditorCommand(workingDir, editor);
+    if (!source.isEmpty())
+        cmd->setCodec(VcsBase::VcsBaseEditor::getCodec(source));
+    enqueueJob(cmd, args, JobScheduler::Interactive);
 }
 
 void FossilClient::log(const QString &workingDir, const QStringList &files,
@@ -982,7 +1675,7 @@ void FossilClient::log(const QString &workingDir, const QStringList &files,
     args << effectiveArgs;
     if (!files.isEmpty())
          args << "--path" << files;
-    enqueueJob(createCommand(workingDir, fossilEditor), args);
+    enqueueJob(createEditorCommand(workingDir, fossilEditor), args, JobScheduler::Normal);
 }
 
 void FossilClient::logCurrentFile(const QString &workingDir, const QStringList &files,
@@ -1032,7 +1725,7 @@ void FossilClient::logCurrentFile(const QString &workingDir, const QStringList &
 
     QStringList args(vcsCmdString);
     args << effectiveArgs << files;
-    enqueueJob(createCommand(workingDir, fossilEditor), args);
+    enqueueJob(createEditorCommand(workingDir, fossilEditor), args, JobScheduler::Normal);
 }
 
 void FossilClient::revertFile(const QString &workingDir,
@@ -1050,7 +1743,7 @@ void FossilClient::revertFile(const QString &workingDir,
     VcsBase::VcsCommand *cmd = createCommand(workingDir);
     cmd->setCookie(QStringList(workingDir + "/" + file));
     connect(cmd, &VcsBase::VcsCommand::success, this, &VcsBase::VcsBaseClient::changed, Qt::QueuedConnection);
-    enqueueJob(cmd, args);
+    enqueueJob(cmd, args, JobScheduler::Normal);
 }
 
 void FossilClient::revertAll(const QString &workingDir, const QString &revision, const QStringList &extraOptions)
@@ -1076,7 +1769,41 @@ void FossilClient::revertAll(const QString &workingDir, const QString &revision,
     VcsBase::VcsCommand *cmd = createCommand(workingDir);
     cmd->setCookie(QStringList(workingDir));
     connect(cmd, &VcsBase::VcsCommand::success, this, &VcsBase::VcsBaseClient::changed, Qt::QueuedConnection);
-    enqueueJob(createCommand(workingDir), args);
+    enqueueJob(cmd, args, JobScheduler::Normal);
+}
+
+void FossilClient::status(const QString &workingDir, const QString &file,
+                          const QStringList &extraOptions)
+{
+    // Same as VcsBaseClient::status(), however started through the job scheduler
+    // and recorded in the command statistics, like the other jobs.
+
+    QStringList args(vcsCommandString(StatusCommand));
+    args << extraOptions;
+    if (!file.isEmpty())
+        args << file;
+
+    VcsBase::VcsOutputWindow::setRepository(workingDir);
+    VcsBase::VcsCommand *cmd = createCommand(workingDir, nullptr, VcsWindowOutputBind);
+    connect(cmd, &VcsBase::VcsCommand::finished,
+            VcsBase::VcsOutputWindow::instance(), &VcsBase::VcsOutputWindow::clearRepository,
+            Qt::QueuedConnection);
+    enqueueJob(cmd, args, JobScheduler::Interactive);
+}
+
+void FossilClient::update(const QString &repositoryRoot, const QString &revision,
+                          const QStringList &extraOptions)
+{
+    // Same as VcsBaseClient::update(), see status()
+
+    QStringList args(vcsCommandString(UpdateCommand));
+    args << revisionSpec(revision) << extraOptions;
+
+    // Indicate repository change
+    VcsBase::VcsCommand *cmd = createCommand(repositoryRoot);
+    cmd->setCookie(repositoryRoot);
+    connect(cmd, &VcsBase::VcsCommand::success, this, &VcsBase::VcsBaseClient::changed, Qt::QueuedConnection);
+    enqueueJob(cmd, args, JobScheduler::Normal);
 }
 
 QString FossilClient::sanitizeFossilOutput(const QString &output) const
@@ -1138,11 +1865,65 @@ QStringList FossilClient::revisionSpec(const QString &revision) const
     return args;
 }
 
-FossilClient::StatusItem FossilClient::parseStatusLine(const QString &line) const
+struct StatusLabel
+{
+    const char *label;
+    int size;
+    const char *flags;
+};
+
+template <int N>
+constexpr StatusLabel statusLabel(const char (&label)[N], const char *flags)
+{
+    return {label, N - 1, flags};
+}
+
+// Ref: fossil source 'src/checkin.c' status_report()
+static constexpr StatusLabel statusLabels[] = {
+    statusLabel("EDITED", Constants::FSTATUS_EDITED),
+    statusLabel("ADDED", Constants::FSTATUS_ADDED),
+    statusLabel("RENAMED", Constants::FSTATUS_RENAMED),
+    statusLabel("DELETED", Constants::FSTATUS_DELETED),
+    statusLabel("MISSING", "Missing"),
+    statusLabel("ADDED_BY_MERGE", Constants::FSTATUS_ADDED_BY_MERGE),
+    statusLabel("UPDATED_BY_MERGE", Constants::FSTATUS_UPDATED_BY_MERGE),
+    statusLabel("ADDED_BY_INTEGRATE", Constants::FSTATUS_ADDED_BY_INTEGRATE),
+    statusLabel("UPDATED_BY_INTEGRATE", Constants::FSTATUS_UPDATED_BY_INTEGRATE),
+    statusLabel("CONFLICT", "Conflict"),
+    statusLabel("EXECUTABLE", "Set Exec"),
+    statusLabel("SYMLINK", "Set Symlink"),
+    statusLabel("UNEXEC", "Unset Exec"),
+    statusLabel("UNLINK", "Unset Symlink"),
+    statusLabel("NOT_A_FILE", Constants::FSTATUS_UNKNOWN)
+};
+
+static const int statusLabelCount = sizeof(statusLabels) / sizeof(statusLabels[0]);
+
+static const QString *statusFlags(const QStringRef &label)
+{
+    // The flag strings are shared by all the parsed status items.
+    static const QVector<QString> flags = []() {
+        QVector<QString> result;
+        result.reserve(statusLabelCount);
+        for (const StatusLabel &statusLabel : statusLabels)
+            result.append(QString::fromLatin1(statusLabel.flags));
+        return result;
+    }();
+
+    for (int i = 0; i < statusLabelCount; ++i) {
+        const StatusLabel &statusLabel = statusLabels[i];
+        if (statusLabel.size == label.size()
+            && label == QLatin1String(statusLabel.label, statusLabel.size)) {
+            return &flags.at(i);
+        }
+    }
+    return nullptr;
+}
+
+FossilClient::StatusItem FossilClient::statusItemFromLine(const QStringRef &line)
 {
     StatusItem item;
 
-    // Ref: fossil source 'src/checkin.c' status_report()
     // Expect at least one non-leading blank space.
 
     int pos = line.indexOf(' ');
@@ -1150,53 +1931,24 @@ FossilClient::StatusItem FossilClient::parseStatusLine(const QString &line) cons
     if (line.isEmpty() || pos < 1)
         return StatusItem();
 
-    QString label(line.left(pos));
-    QString flags;
-
-    if (label == "EDITED")
-        flags = Constants::FSTATUS_EDITED;
-    else if (label == "ADDED")
-        flags = Constants::FSTATUS_ADDED;
-    else if (label == "RENAMED")
-        flags = Constants::FSTATUS_RENAMED;
-    else if (label == "DELETED")
-        flags = Constants::FSTATUS_DELETED;
-    else if (label == "MISSING")
-        flags = "Missing";
-    else if (label == "ADDED_BY_MERGE")
-        flags = Constants::FSTATUS_ADDED_BY_MERGE;
-    else if (label == "UPDATED_BY_MERGE")
-        flags = Constants::FSTATUS_UPDATED_BY_MERGE;
-    else if (label == "ADDED_BY_INTEGRATE")
-        flags = Constants::FSTATUS_ADDED_BY_INTEGRATE;
-    else if (label == "UPDATED_BY_INTEGRATE")
-        flags = Constants::FSTATUS_UPDATED_BY_INTEGRATE;
-    else if (label == "CONFLICT")
-        flags = "Conflict";
-    else if (label == "EXECUTABLE")
-        flags = "Set Exec";
-    else if (label == "SYMLINK")
-        flags = "Set Symlink";
-    else if (label == "UNEXEC")
-        flags = "Unset Exec";
-    else if (label == "UNLINK")
-        flags = "Unset Symlink";
-    else if (label == "NOT_A_FILE")
-        flags = Constants::FSTATUS_UNKNOWN;
-
-
-    if (flags.isEmpty())
+    const QString *flags = statusFlags(line.left(pos));
+    if (!flags)
         return StatusItem();
 
     // adjust the position to the last space before the file name
-    for (int size = line.size(); (pos+1) < size && line[pos+1].isSpace(); ++pos) {}
+    for (int size = line.size(); (pos+1) < size && line.at(pos+1).isSpace(); ++pos) {}
 
-    item.flags = flags;
-    item.file = line.mid(pos + 1);
+    item.flags = *flags;
+    item.file = line.mid(pos + 1).toString();
 
     return item;
 }
 
+FossilClient::StatusItem FossilClient::parseStatusLine(const QString &line) const
+{
+    return statusItemFromLine(QStringRef(&line));
+}
+
 VcsBase::VcsBaseEditorConfig *FossilClient::createAnnotateEditor(VcsBase::VcsBaseEditorWidget *editor)
 {
     return new FossilAnnotateConfig(this, editor->toolBar());
@@ -1217,6 +1969,28 @@ VcsBase::VcsBaseEditorConfig *FossilClient::createLogEditor(VcsBase::VcsBaseEdit
     return new FossilLogConfig(this, editor->toolBar());
 }
 
+VcsBase::VcsCommand *FossilClient::createEditorCommand(const QString &workingDir,
+                                                       VcsBase::VcsBaseEditorWidget *editor)
+{
+    // Re-running annotate/log/diff for an editor, e.g. on toggling an option,
+    // supersedes the command still running for it. A superseded command that
+    // has not started is dropped, a running one is aborted, which kills the
+    // fossil process; either way its output is not shown.
+
+    VcsBase::VcsCommand *cmd = createCommand(workingDir, editor);
+
+    auto *fossilEditor = qobject_cast<FossilEditorWidget *>(editor);
+    QTC_ASSERT(fossilEditor, return cmd);
+
+    if (VcsBase::VcsCommand *superseded = fossilEditor->replaceCommand(cmd)) {
+        // Nor do the client's own handlers act on it
+        disconnect(superseded, nullptr, this, nullptr);
+        if (!m_jobScheduler->cancel(superseded))
+            superseded->abort();
+    }
+    return cmd;
+}
+
 } // namespace Internal
 } // namespace Fossil
 
@@ -29,16 +29,34 @@
 #include "fossilsettings.h"
 #include "branchinfo.h"
 #include "revisioninfo.h"
+#include "binarycapabilities.h"
+#include "jobscheduler.h"
+#include "statustracker.h"
 
 #include <vcsbase/vcsbaseclient.h>
 
+#include <QElapsedTimer>
+#include <QHash>
 #include <QList>
+#include <QScopedPointer>
+#include <QSharedPointer>
+
+QT_BEGIN_NAMESPACE
+class QUrl;
+QT_END_NAMESPACE
 
 namespace Fossil {
 namespace Internal {
 
+class BlockingDetector;
+class CommandStatistics;
+class InFlightQueries;
 class FossilSettings;
 class FossilControl;
+class SyncProgress;
+class SyncProxy;
+class RepositoryTemplatePool;
+class TopLevelCache;
 
 class FossilClient : public VcsBase::VcsBaseClient
 {
@@ -49,20 +67,35 @@ public:
         TimelineWidthFeature = 0x4,
         DiffIgnoreWhiteSpaceFeature = 0x8,
         TimelinePathFeature = 0x10,
+        ChangesPathFeature = 0x20,
+        ConfigTableFeature = 0x40,
         AllSupportedFeatures =  // | all defined features
             AnnotateBlameFeature
             | TimelineWidthFeature
             | DiffIgnoreWhiteSpaceFeature
             | TimelinePathFeature
+            | ChangesPathFeature
+            | ConfigTableFeature
     };
     Q_DECLARE_FLAGS(SupportedFeatures, SupportedFeature)
 
     static unsigned makeVersionNumber(int major, int minor, int patch);
     static QString makeVersionString(unsigned version);
+    static SupportedFeatures featuresForVersion(unsigned version);
 
     FossilClient();
 
-    unsigned int synchronousBinaryVersion() const;
+    StatusTracker *statusTracker() const;
+    RepositoryTemplatePool *repositoryTemplatePool() const;
+    TopLevelCache *topLevelCache() const;
+    CommandStatistics *commandStatistics() const;
+    BlockingDetector *blockingDetector() const;
+    JobScheduler *jobScheduler() const;
+    SyncProxy *syncProxy() const;
+    void emitTrackedStatus(const QString &repository, JobScheduler::Priority priority);
+    // Drops the query results kept for the checkout of a file or directory.
+    void invalidateQueries(const QString &path);
+
     BranchInfo synchronousCurrentBranch(const QString &workingDirectory);
     QList<BranchInfo> synchronousBranchQuery(const QString &workingDirectory);
     RevisionInfo synchronousRevisionQuery(const QString &workingDirectory, const QString &id = QString());
@@ -78,20 +111,30 @@ public:
     QString synchronousTopic(const QString &workingDirectory);
     bool synchronousCreateRepository(const QString &workingDirectory,
                                      const QStringList &extraOptions = QStringList()) final;
+    bool addWhenOpened(const QString &workingDir, const QString &fileName);
+    bool synchronousAdd(const QString &workingDir, const QString &fileName,
+                        const QStringList &extraOptions = QStringList()) final;
+    bool synchronousRemove(const QString &workingDir, const QString &fileName,
+                           const QStringList &extraOptions = QStringList()) final;
     bool synchronousMove(const QString &workingDir,
                          const QString &from, const QString &to,
                          const QStringList &extraOptions = QStringList()) final;
-    bool synchronousPull(const QString &workingDir,
-                         const QString &srcLocation,
-                         const QStringList &extraOptions = QStringList()) final;
-    bool synchronousPush(const QString &workingDir,
-                         const QString &dstLocation,
-                         const QStringList &extraOptions = QStringList()) final;
+    void pull(const QString &workingDir, const QString &srcLocation,
+              const QStringList &extraOptions = QStringList());
+    void push(const QString &workingDir, const QString &dstLocation,
+              const QStringList &extraOptions = QStringList());
+    VcsBase::VcsCommand *createSyncCommand(const QString &workingDir,
+                                           const QSharedPointer<SyncProgress> &progress);
+    QStringList syncArguments(const QString &workingDir, const QString &verb,
+                              const QString &remoteLocation = QString(),
+                              const QStringList &extraOptions = QStringList());
     void commit(const QString &repositoryRoot, const QStringList &files,
                 const QString &commitMessageFile, const QStringList &extraOptions = QStringList()) final;
     VcsBase::VcsBaseEditorWidget *annotate(
             const QString &workingDir, const QString &file, const QString &revision = QString(),
             int lineNumber = -1, const QStringList &extraOptions = QStringList()) final;
+    void diff(const QString &workingDir, const QStringList &files = QStringList(),
+              const QStringList &extraOptions = QStringList()) final;
     void log(const QString &workingDir, const QStringList &files = QStringList(),
              const QStringList &extraOptions = QStringList(),
              bool enableAnnotationContextMenu = false) final;
@@ -103,18 +146,67 @@ public:
                     const QStringList &extraOptions = QStringList()) final;
     void revertAll(const QString &workingDir, const QString &revision = QString(),
                    const QStringList &extraOptions = QStringList()) final;
+    void status(const QString &workingDir, const QString &file = QString(),
+                const QStringList &extraOptions = QStringList()) final;
+    void update(const QString &repositoryRoot, const QString &revision = QString(),
+                const QStringList &extraOptions = QStringList()) final;
     bool isVcsFileOrDirectory(const Utils::FileName &fileName) const;
     QString findTopLevelForFile(const QFileInfo &file) const final;
     bool managesFile(const QString &workingDirectory, const QString &fileName) const;
+    const BinaryCapabilities &binaryCapabilities() const;
     unsigned int binaryVersion() const;
     QString binaryVersionString() const;
     SupportedFeatures supportedFeatures() const;
     void view(const QString &source, const QString &id,
               const QStringList &extraOptions = QStringList()) final;
 
+    // These hide the VcsBaseClient versions to record each spawned process
+    // in the command statistics. Jobs are started through the job scheduler.
+    Utils::SynchronousProcessResponse vcsFullySynchronousExec(
+            const QString &workingDir, const QStringList &args, unsigned flags = 0,
+            int timeoutMultiplier = 1, QTextCodec *codec = nullptr) const;
+    Utils::SynchronousProcessResponse vcsSynchronousExec(
+            const QString &workingDir, const QStringList &args, unsigned flags = 0,
+            QTextCodec *outputCodec = nullptr) const;
+    // The priority is that of the caller: whether the user waits on the result.
+    void enqueueJob(VcsBase::VcsCommand *cmd, const QStringList &args, JobScheduler::Priority priority,
+                    const QString &workingDirectory = QString(),
+                    Utils::ExitCodeInterpreter *interpreter = nullptr) const;
+
 private:
     static QList<BranchInfo> branchListFromOutput(const QString &output, const BranchInfo::BranchFlags defaultFlags = 0);
+    static StatusItem statusItemFromLine(const QStringRef &line);
+    static RevisionInfo revisionInfoFromOutput(const QString &output, const QString &id = QString());
+    static bool settingsFromConfigTableOutput(const QString &output, RepositorySettings *repoSettings);
+    static void settingsFromSettingsOutput(const QString &output, RepositorySettings *repoSettings);
+    static QByteArray argumentsFileContents(const QStringList &files);
+    static bool topicFromOutput(const QString &output, QString *topic);
 
+    bool synchronousConfigTableQuery(const QString &workingDirectory, RepositorySettings *repoSettings);
+    bool synchronousSettingsCommandQuery(const QString &workingDirectory, RepositorySettings *repoSettings);
+
+    // The remote a repository syncs with and the settings that decide whether
+    // its syncs can be relayed. Kept for a while, as the background pulls and
+    // Sync All look them up on the GUI thread for every sync.
+    struct SyncRemote
+    {
+        QString url;
+        bool settingsKnown = false;
+        QString sslIdentity;
+        QString sslCaLocation;
+        QString proxy;
+        QStringList acceptedCertificateHosts;
+        qint64 expiresMs = 0;
+    };
+    const SyncRemote &syncRemote(const QString &workingDir);
+    void invalidateSyncRemote(const QString &workingDir);
+    bool canRelay(const SyncRemote &remote, const QUrl &url) const;
+    static bool relaySettingsFromOutput(const QString &output, SyncRemote *remote);
+
+    void sync(VcsCommandTag cmd, const QString &workingDir, const QString &remoteLocation,
+              const QStringList &extraOptions);
+    void scanStatus(const QString &repository, JobScheduler::Priority priority,
+                    bool tracked, const StatusTracker::FileStamps &stamps);
     QString sanitizeFossilOutput(const QString &output) const;
     QString vcsCommandString(VcsCommandTag cmd) const final;
     Core::Id vcsEditorKind(VcsCommandTag cmd) const final;
@@ -123,8 +215,29 @@ private:
     VcsBase::VcsBaseEditorConfig *createAnnotateEditor(VcsBase::VcsBaseEditorWidget *editor);
     VcsBase::VcsBaseEditorConfig *createLogCurrentFileEditor(VcsBase::VcsBaseEditorWidget *editor);
     VcsBase::VcsBaseEditorConfig *createLogEditor(VcsBase::VcsBaseEditorWidget *editor);
+    VcsBase::VcsCommand *createEditorCommand(const QString &workingDir,
+                                             VcsBase::VcsBaseEditorWidget *editor);
+
+    void reprobeBinaryCapabilities() const;
+
+    StatusTracker *m_statusTracker;
+    RepositoryTemplatePool *m_repositoryTemplatePool;
+    TopLevelCache *m_topLevelCache;
+    CommandStatistics *m_commandStatistics;
+    BlockingDetector *m_blockingDetector;
+    const QScopedPointer<InFlightQueries> m_inFlightQueries;
+    JobScheduler *m_jobScheduler;
+    SyncProxy *m_syncProxy;
+    mutable BinaryCapabilities m_binaryCapabilities;
+    mutable QElapsedTimer m_binaryCapabilitiesChecked;
+    mutable bool m_reprobingBinaryCapabilities = false;
+    QHash<QString, SyncRemote> m_syncRemotes;
+    QElapsedTimer m_syncRemotesClock;
+    // Checkouts being opened after their creation, with the files to add then
+    QHash<QString, QStringList> m_openingCheckouts;
 
     friend class FossilControl;
+    friend class FossilPlugin;
 };
 
 Q_DECLARE_OPERATORS_FOR_FLAGS(FossilClient::SupportedFeatures)
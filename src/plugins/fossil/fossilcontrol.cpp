@@ -24,16 +24,21 @@
 **  THE SOFTWARE.
 **************************************************************************/
 
+#include "commandstatistics.h"
 #include "constants.h"
 #include "fossilcontrol.h"
 #include "fossilclient.h"
 #include "fossilplugin.h"
+#include "syncprogressparser.h"
+#include "toplevelcache.h"
 #include "wizard/fossiljsextension.h"
 
 #include <vcsbase/vcsbaseclientsettings.h>
 #include <vcsbase/vcsbaseconstants.h>
 #include <vcsbase/vcscommand.h>
 
+#include <QElapsedTimer>
+#include <QFile>
 #include <QFileInfo>
 #include <QProcessEnvironment>
 #include <QVariant>
@@ -45,6 +50,93 @@
 namespace Fossil {
 namespace Internal {
 
+// Runs the initial checkout jobs. While the repository is being cloned
+// a marker is kept next to the repository file, so that the partial
+// repository left by an interrupted clone is cleaned up before cloning
+// again. Interrupted clones are not resumed, they start over.
+// The time taken by each stage is reported along with the job output.
+class FossilCloneCommand : public VcsBase::VcsCommand
+{
+public:
+    FossilCloneCommand(const QString &workingDirectory, const QProcessEnvironment &environment,
+                       const QString &repositoryFile, CommandStatistics *statistics) :
+        VcsBase::VcsCommand(workingDirectory, environment),
+        m_statistics(statistics),
+        m_repositoryFile(repositoryFile),
+        m_pendingMarker(pendingMarker(repositoryFile)),
+        m_progress(new SyncProgress)
+    {
+        setProgressParser(new SyncProgressParser(m_progress));
+    }
+
+    static QString pendingMarker(const QString &repositoryFile)
+    {
+        return repositoryFile + ".clone-pending";
+    }
+
+protected:
+    Utils::SynchronousProcessResponse runCommand(const Utils::FileName &binary,
+                                                 const QStringList &arguments, int timeoutS,
+                                                 const QString &workingDirectory,
+                                                 Utils::ExitCodeInterpreter *interpreter) override
+    {
+        const QString verb = arguments.value(0);
+        const bool isClone = (verb == "clone");
+        if (isClone) {
+            // Fossil does not clone into an existing file
+            if (QFileInfo::exists(m_pendingMarker) && QFile::remove(m_repositoryFile)) {
+                emit stdOutText(FossilControl::tr("Removed %1 left by an interrupted clone.\n")
+                                .arg(QDir::toNativeSeparators(m_repositoryFile)));
+            }
+            QFile(m_pendingMarker).open(QIODevice::WriteOnly);
+        }
+
+        if (!m_totalTimer.isValid())
+            m_totalTimer.start();
+        QElapsedTimer timer;
+        timer.start();
+        const qint64 startUs = m_statistics->nowUs();
+
+        const Utils::SynchronousProcessResponse response =
+                VcsBase::VcsCommand::runCommand(binary, arguments, timeoutS, workingDirectory, interpreter);
+        const bool ok = (response.result == Utils::SynchronousProcessResponse::Finished);
+        m_statistics->record(verb, workingDirectory.isEmpty() ? defaultWorkingDirectory() : workingDirectory,
+                             startUs, response.rawStdOut.size() + response.rawStdErr.size(), ok);
+
+        QString stage;
+        if (isClone)
+            stage = FossilControl::tr("Clone");
+        else if (verb == "open")
+            stage = FossilControl::tr("Open");
+        else
+            stage = FossilControl::tr("Configure");
+
+        QString timing = FossilControl::tr("%1 %2 in %3 s (total %4 s)")
+                .arg(stage)
+                .arg(ok ? FossilControl::tr("done") : FossilControl::tr("failed"))
+                .arg(timer.elapsed() / 1000.0, 0, 'f', 1)
+                .arg(m_totalTimer.elapsed() / 1000.0, 0, 'f', 1);
+        if (isClone) {
+            const SyncStatistics stats = m_progress->statistics();
+            timing += FossilControl::tr(", %1 artifacts, %2 bytes received")
+                    .arg(stats.artifactsReceived)
+                    .arg(stats.bytesReceived);
+            if (ok)
+                QFile::remove(m_pendingMarker);
+        }
+        emit stdOutText(timing + ".\n");
+
+        return response;
+    }
+
+private:
+    CommandStatistics *const m_statistics;
+    const QString m_repositoryFile;
+    const QString m_pendingMarker;
+    const QSharedPointer<SyncProgress> m_progress;
+    QElapsedTimer m_totalTimer;
+};
+
 class FossilTopicCache : public Core::IVersionControl::TopicCache
 {
 public:
@@ -89,8 +181,7 @@ bool FossilControl::isVcsFileOrDirectory(const Utils::FileName &fileName) const
 
 bool FossilControl::managesDirectory(const QString &directory, QString *topLevel) const
 {
-    QFileInfo dir(directory);
-    const QString topLevelFound = m_client->findTopLevelForFile(dir);
+    const QString topLevelFound = m_client->topLevelCache()->topLevel(directory);
     if (topLevel)
         *topLevel = topLevelFound;
     return !topLevelFound.isEmpty();
@@ -151,6 +242,8 @@ bool FossilControl::vcsOpen(const QString &filename)
 bool FossilControl::vcsAdd(const QString &filename)
 {
     const QFileInfo fi(filename);
+    if (m_client->addWhenOpened(fi.absolutePath(), fi.fileName()))
+        return true;
     return m_client->synchronousAdd(fi.absolutePath(), fi.fileName());
 }
 
@@ -229,11 +322,24 @@ Core::ShellCommand *FossilControl::createInitialCheckoutCommand(const QString &s
     const QDir checkoutDir(checkoutPath);
     checkoutDir.mkpath(checkoutPath);
 
+    // The directory may have been resolved as not being under version control
+    TopLevelCache *topLevelCache = m_client->topLevelCache();
+    topLevelCache->invalidate(checkoutPath);
+
     // Setup the wizard page command job
-    auto command = new VcsBase::VcsCommand(checkoutDir.path(), m_client->processEnvironment());
+    auto command = new FossilCloneCommand(checkoutDir.path(), m_client->processEnvironment(),
+                                          cloneRepository.absoluteFilePath(),
+                                          m_client->commandStatistics());
+
+    // An interrupted clone leaves the partial repository file along with the marker.
+    // It lacks the project code and configuration a pull would need, so it is
+    // cleaned up and replaced by a new clone with the same options.
+    const bool isInterruptedClone =
+            cloneRepository.exists()
+            && QFileInfo::exists(FossilCloneCommand::pendingMarker(cloneRepository.absoluteFilePath()));
 
     if (!isLocalRepository
-        && !cloneRepository.exists()) {
+        && (!cloneRepository.exists() || isInterruptedClone)) {
 
         const QString sslIdentityFile = options.value("ssl-identity");
         const Utils::FileName sslIdentityFileName = Utils::FileName::fromUserInput(QDir::fromNativeSeparators(sslIdentityFile));
@@ -291,6 +397,10 @@ Core::ShellCommand *FossilControl::createInitialCheckoutCommand(const QString &s
         command->addJob(m_client->vcsBinary(), args, -1);
     }
 
+    QObject::connect(command, &VcsBase::VcsCommand::finished, topLevelCache, [topLevelCache, checkoutPath]() {
+        topLevelCache->invalidate(checkoutPath);
+    });
+
     return command;
 }
 
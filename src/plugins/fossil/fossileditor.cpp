@@ -34,6 +34,7 @@
 #include <utils/qtcassert.h>
 #include <utils/synchronousprocess.h>
 #include <vcsbase/diffandloghighlighter.h>
+#include <vcsbase/vcscommand.h>
 
 #include <QRegularExpression>
 #include <QRegExp>
@@ -42,6 +43,7 @@
 #include <QTextBlock>
 #include <QDir>
 #include <QFileInfo>
+#include <QPointer>
 
 namespace Fossil {
 namespace Internal {
@@ -51,21 +53,16 @@ class FossilEditorWidgetPrivate
 public:
     FossilEditorWidgetPrivate() :
         m_exactChangesetId(Constants::CHANGESET_ID_EXACT),
-        m_firstChangesetId(QString("\n") + Constants::CHANGESET_ID + " "),
-        m_nextChangesetId(m_firstChangesetId),
         m_configurationWidget(nullptr)
     {
         QTC_ASSERT(m_exactChangesetId.isValid(), return);
-        QTC_ASSERT(m_firstChangesetId.isValid(), return);
-        QTC_ASSERT(m_nextChangesetId.isValid(), return);
     }
 
 
     const QRegularExpression m_exactChangesetId;
-    const QRegularExpression m_firstChangesetId;
-    const QRegularExpression m_nextChangesetId;
 
     VcsBase::VcsBaseEditorConfig *m_configurationWidget;
+    QPointer<VcsBase::VcsCommand> m_command;
 };
 
 FossilEditorWidget::FossilEditorWidget() :
@@ -103,24 +100,42 @@ VcsBase::VcsBaseEditorConfig *FossilEditorWidget::configurationWidget() const
     return d->m_configurationWidget;
 }
 
+VcsBase::VcsCommand *FossilEditorWidget::replaceCommand(VcsBase::VcsCommand *command)
+{
+    VcsBase::VcsCommand *previous = d->m_command;
+    d->m_command = command;
+    if (!previous || previous == command)
+        return nullptr;
+
+    // Whatever the superseded command still produces must not reach the editor
+    disconnect(previous, nullptr, this, nullptr);
+    disconnect(previous, nullptr, textDocument(), nullptr);
+    return previous;
+}
+
 QSet<QString> FossilEditorWidget::annotationChanges() const
 {
+    return changesFromAnnotation(toPlainText());
+}
 
-    const QString txt = toPlainText();
+QSet<QString> FossilEditorWidget::changesFromAnnotation(const QString &txt)
+{
     if (txt.isEmpty())
         return QSet<QString>();
 
     // extract changeset id at the beginning of each annotated line:
     // <changeid> ...:
+    static const QRegularExpression changesetIdRx(QString("\n") + Constants::CHANGESET_ID + " ");
+    QTC_ASSERT(changesetIdRx.isValid(), return QSet<QString>());
 
     QSet<QString> changes;
 
-    QRegularExpressionMatch firstChangesetIdMatch = d->m_firstChangesetId.match(txt);
+    QRegularExpressionMatch firstChangesetIdMatch = changesetIdRx.match(txt);
     if (firstChangesetIdMatch.hasMatch()) {
         QString changeId = firstChangesetIdMatch.captured(1);
         changes.insert(changeId);
 
-        QRegularExpressionMatchIterator i = d->m_nextChangesetId.globalMatch(txt);
+        QRegularExpressionMatchIterator i = changesetIdRx.globalMatch(txt);
         while (i.hasNext()) {
             const QRegularExpressionMatch nextChangesetIdMatch = i.next();
             changeId = nextChangesetIdMatch.captured(1);
@@ -28,6 +28,8 @@
 
 #include <vcsbase/vcsbaseeditor.h>
 
+namespace VcsBase { class VcsCommand; }
+
 namespace Fossil {
 namespace Internal {
 
@@ -44,6 +46,12 @@ public:
     bool setConfigurationWidget(VcsBase::VcsBaseEditorConfig *w);
     VcsBase::VcsBaseEditorConfig *configurationWidget() const;
 
+    // Makes command the one whose output this editor shows. Returns the
+    // previous command if it is still alive; its output is no longer shown.
+    VcsBase::VcsCommand *replaceCommand(VcsBase::VcsCommand *command);
+
+    static QSet<QString> changesFromAnnotation(const QString &text);
+
 private:
     QSet<QString> annotationChanges() const final;
     QString changeUnderCursor(const QTextCursor &cursor) const final;
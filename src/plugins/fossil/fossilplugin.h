@@ -32,6 +32,8 @@
 #include <vcsbase/vcsbaseplugin.h>
 #include <coreplugin/icontext.h>
 
+#include <QPointer>
+
 QT_BEGIN_NAMESPACE
 class QAction;
 QT_END_NAMESPACE
@@ -47,10 +49,13 @@ namespace Utils { class ParameterAction; }
 namespace Fossil {
 namespace Internal {
 
+class CommandStatisticsDialog;
 class OptionsPage;
 class FossilClient;
 class FossilControl;
 class FossilEditorWidget;
+class PullScheduler;
+class SyncAllRunner;
 
 class FossilPlugin : public VcsBase::VcsBasePlugin
 {
@@ -61,6 +66,7 @@ public:
     FossilPlugin();
     ~FossilPlugin();
     bool initialize(const QStringList &arguments, QString *errorMessage);
+    ShutdownFlag aboutToShutdown() override;
 
     static FossilPlugin *instance();
     FossilClient *client() const;
@@ -88,9 +94,12 @@ private:
     // Repository menu action slots
     void pull();
     void push();
+    void syncAll();
+    void showCommandStatistics();
     void update();
     void configureRepository();
     void commit();
+    void startCommit(const QString &topLevel);
     void showCommitWidget(const QList<VcsBase::VcsBaseClient::StatusItem> &status);
     void commitFromEditor();
     void diffFromEditorSelected(const QStringList &files);
@@ -98,10 +107,13 @@ private:
 
     // Methods
     void createMenu(const Core::Context &context);
+    void createGlobalActions();
+    void materializeActions();
     void createSubmitEditorActions();
     void createFileActions(const Core::Context &context);
     void createDirectoryActions(const Core::Context &context);
     void createRepositoryActions(const Core::Context &context);
+    QStringList openRepositories() const;
 
     // Variables
     static FossilPlugin *m_instance;
@@ -109,6 +121,8 @@ private:
 
     Core::CommandLocator *m_commandLocator = nullptr;
     Core::ActionContainer *m_fossilContainer = nullptr;
+    Core::Context m_menuContext;
+    bool m_actionsMaterialized = false;
 
     QList<QAction *> m_repositoryActionList;
 
@@ -123,6 +137,11 @@ private:
     Utils::ParameterAction *m_statusFile = nullptr;
 
     QAction *m_createRepositoryAction = nullptr;
+    QAction *m_syncAllAction = nullptr;
+    QPointer<SyncAllRunner> m_syncAllRunner;
+    QAction *m_commandStatisticsAction = nullptr;
+    QPointer<CommandStatisticsDialog> m_commandStatisticsDialog;
+    PullScheduler *m_pullScheduler = nullptr;
 
     // Submit editor actions
     QAction *m_editorCommit = nullptr;
@@ -137,9 +156,64 @@ private:
 
 #ifdef WITH_TESTS
 private slots:
+    void cleanupTestCase();
     void testDiffFileResolving_data();
     void testDiffFileResolving();
     void testLogResolving();
+    void testStatusLineParsing_data();
+    void testStatusLineParsing();
+    void benchmarkStatusLineParsing_data();
+    void benchmarkStatusLineParsing();
+    void testOutputLines_data();
+    void testOutputLines();
+    void benchmarkOutputLinesMemory_data();
+    void benchmarkOutputLinesMemory();
+    void benchmarkBranchListParsing_data();
+    void benchmarkBranchListParsing();
+    void benchmarkSettingsParsing_data();
+    void benchmarkSettingsParsing();
+    void benchmarkRevisionParsing_data();
+    void benchmarkRevisionParsing();
+    void benchmarkLogHighlighter_data();
+    void benchmarkLogHighlighter();
+    void benchmarkAnnotationHighlighter_data();
+    void benchmarkAnnotationHighlighter();
+    void benchmarkAnnotationChanges_data();
+    void benchmarkAnnotationChanges();
+    void testArgumentsFile();
+    void benchmarkCommitFiles();
+    void benchmarkCommit();
+    void testTopLevelCacheListings();
+    void benchmarkTopLevelCache_data();
+    void benchmarkTopLevelCache();
+    void benchmarkIsVcsFileOrDirectory_data();
+    void benchmarkIsVcsFileOrDirectory();
+    void testBinaryCapabilities();
+    void testRepositorySettings();
+    void testCommandStatistics();
+    void testCommandStatisticsInstrument();
+    void testBlockingDetector();
+    void testFakeFossil();
+    void testFakeFossilCancel();
+    void benchmarkOperations_data();
+    void benchmarkOperations();
+    void benchmarkStatusOverhead_data();
+    void benchmarkStatusOverhead();
+    void testInFlightQueries();
+    void testJobScheduler();
+    void testStatusPriority();
+    void testSupersededCommand();
+    void testStatusTracker();
+    void testPullSchedulerBackoff();
+    void testPullScheduler();
+    void testSyncProgressParser_data();
+    void testSyncProgressParser();
+    void testSyncProxy();
+    void benchmarkSyncProxy_data();
+    void benchmarkSyncProxy();
+    void testSyncRemote();
+    void testCreateRepository();
+    void testTopic();
 #endif
 };
 
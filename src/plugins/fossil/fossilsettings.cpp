@@ -43,6 +43,11 @@ const QString FossilSettings::timelineLineageFilterKey("timelineLineageFilter");
 const QString FossilSettings::timelineVerboseKey("timelineVerbose");
 const QString FossilSettings::timelineItemTypeKey("timelineItemType");
 const QString FossilSettings::disableAutosyncKey("disableAutosync");
+const QString FossilSettings::incrementalStatusKey("incrementalStatus");
+const QString FossilSettings::syncConcurrencyKey("syncConcurrency");
+const QString FossilSettings::backgroundPullIntervalKey("backgroundPullInterval");
+const QString FossilSettings::syncProxyKey("syncProxy");
+const QString FossilSettings::repositoryTemplatesKey("repositoryTemplates");
 
 FossilSettings::FossilSettings()
 {
@@ -60,6 +65,11 @@ FossilSettings::FossilSettings()
     declareKey(timelineVerboseKey, false);
     declareKey(timelineItemTypeKey, "all");
     declareKey(disableAutosyncKey, true);
+    declareKey(incrementalStatusKey, false);
+    declareKey(syncConcurrencyKey, 4);
+    declareKey(backgroundPullIntervalKey, 0);
+    declareKey(syncProxyKey, false);
+    declareKey(repositoryTemplatesKey, 0);
 }
 
 RepositorySettings::RepositorySettings()
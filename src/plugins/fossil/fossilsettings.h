@@ -45,6 +45,11 @@ public:
     static const QString timelineVerboseKey;
     static const QString timelineItemTypeKey;
     static const QString disableAutosyncKey;
+    static const QString incrementalStatusKey;
+    static const QString syncConcurrencyKey;
+    static const QString backgroundPullIntervalKey;
+    static const QString syncProxyKey;
+    static const QString repositoryTemplatesKey;
 
     FossilSettings();
 };
@@ -0,0 +1,159 @@
+/**************************************************************************
+**  This file is part of Fossil VCS plugin for Qt Creator
+**
+**  Copyright (c) 2013 - 2017, Artur Shepilko, <qtc-fossil@nomadbyte.com>.
+**
+**  Based on Bazaar VCS plugin for Qt Creator by Hugues Delorme.
+**
+**  Permission is hereby granted, free of charge, to any person obtaining a copy
+**  of this software and associated documentation files (the "Software"), to deal
+**  in the Software without restriction, including without limitation the rights
+**  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+**  copies of the Software, and to permit persons to whom the Software is
+**  furnished to do so, subject to the following conditions:
+**
+**  The above copyright notice and this permission notice shall be included in
+**  all copies or substantial portions of the Software.
+**
+**  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+**  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+**  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+**  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+**  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+**  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+**  THE SOFTWARE.
+**************************************************************************/
+
+#include "inflightqueries.h"
+
+#include <QWaitCondition>
+
+namespace Fossil {
+namespace Internal {
+
+struct InFlightQueries::Entry
+{
+    bool done = false;
+    int waiters = 0;
+    Utils::SynchronousProcessResponse response;
+    QWaitCondition finished;
+};
+
+InFlightQueries::InFlightQueries()
+{
+    m_clock.start();
+}
+
+Utils::SynchronousProcessResponse InFlightQueries::run(const QString &workingDirectory,
+                                                       const QString &topLevel,
+                                                       const QStringList &args, unsigned flags,
+                                                       const Query &query, bool *merged)
+{
+    const QString key = workingDirectory + QChar(0) + QString::number(flags)
+            + QChar(0) + args.join(QChar(0));
+
+    QMutexLocker locker(&m_mutex);
+    const auto result = m_results.constFind(key);
+    if (result != m_results.constEnd() && result->expiresMs > m_clock.elapsed()) {
+        if (merged)
+            *merged = true;
+        return result->response;
+    }
+
+    if (QSharedPointer<Entry> entry = m_entries.value(key)) {
+        ++entry->waiters;
+        while (!entry->done)
+            entry->finished.wait(&m_mutex);
+        if (merged)
+            *merged = true;
+        return entry->response;
+    }
+
+    QSharedPointer<Entry> entry(new Entry);
+    m_entries.insert(key, entry);
+    const quint64 generation = m_generation;
+    locker.unlock();
+
+    const Utils::SynchronousProcessResponse response = query();
+
+    locker.relock();
+    entry->response = response;
+    entry->done = true;
+    m_entries.remove(key);
+    entry->finished.wakeAll();
+
+    // Not kept if the checkout was invalidated while the query ran
+    if (generation == m_generation
+            && response.result == Utils::SynchronousProcessResponse::Finished) {
+        const qint64 now = m_clock.elapsed();
+        for (auto it = m_results.begin(); it != m_results.end(); ) {
+            if (it->expiresMs <= now)
+                it = m_results.erase(it);
+            else
+                ++it;
+        }
+        m_results.insert(key, {topLevel, response, now + resultTtlMs});
+    }
+    if (merged)
+        *merged = false;
+    return response;
+}
+
+void InFlightQueries::invalidate(const QString &topLevel)
+{
+    QMutexLocker locker(&m_mutex);
+    ++m_generation;
+    if (topLevel.isEmpty()) {
+        m_results.clear();
+        return;
+    }
+    for (auto it = m_results.begin(); it != m_results.end(); ) {
+        if (it->topLevel == topLevel)
+            it = m_results.erase(it);
+        else
+            ++it;
+    }
+}
+
+int InFlightQueries::inFlightCount() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_entries.size();
+}
+
+int InFlightQueries::waiterCount() const
+{
+    QMutexLocker locker(&m_mutex);
+    int waiters = 0;
+    for (const QSharedPointer<Entry> &entry : m_entries)
+        waiters += entry->waiters;
+    return waiters;
+}
+
+int InFlightQueries::resultCount() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_results.size();
+}
+
+bool InFlightQueries::isReadOnly(const QStringList &args)
+{
+    const QString verb = args.value(0);
+    if (verb == "info" || verb == "version" || verb == "changes" || verb == "status"
+            || verb == "timeline" || verb == "finfo") {
+        return true;
+    }
+    if (verb == "branch" || verb == "tag")
+        return args.value(1) == "list";
+    // Without a value these only report it
+    if (verb == "remote-url" || verb == "settings")
+        return args.size() == 1;
+    if (verb == "user")
+        return args.size() == 2 && args.at(1) == "default";
+    if (verb == "sql")
+        return args.size() == 2 && args.at(1).trimmed().startsWith("SELECT", Qt::CaseInsensitive);
+    return false;
+}
+
+} // namespace Internal
+} // namespace Fossil
@@ -0,0 +1,90 @@
+/**************************************************************************
+**  This file is part of Fossil VCS plugin for Qt Creator
+**
+**  Copyright (c) 2013 - 2017, Artur Shepilko, <qtc-fossil@nomadbyte.com>.
+**
+**  Based on Bazaar VCS plugin for Qt Creator by Hugues Delorme.
+**
+**  Permission is hereby granted, free of charge, to any person obtaining a copy
+**  of this software and associated documentation files (the "Software"), to deal
+**  in the Software without restriction, including without limitation the rights
+**  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+**  copies of the Software, and to permit persons to whom the Software is
+**  furnished to do so, subject to the following conditions:
+**
+**  The above copyright notice and this permission notice shall be included in
+**  all copies or substantial portions of the Software.
+**
+**  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+**  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+**  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+**  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+**  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+**  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+**  THE SOFTWARE.
+**************************************************************************/
+
+#pragma once
+
+#include <utils/synchronousprocess.h>
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QMutex>
+#include <QSharedPointer>
+#include <QStringList>
+
+#include <functional>
+
+namespace Fossil {
+namespace Internal {
+
+// Merges identical read-only queries (same arguments, flags and working
+// directory) into a single fossil process. Callers arriving while one runs
+// on another thread wait and get a copy of its response. As the queries of
+// the GUI thread never overlap, a successful response is also kept for a
+// short while, until the checkout it was run in is invalidated, so that the
+// branch, revision and topic queries issued at once when a project opens
+// spawn fossil only once each. The client invalidates a checkout on the
+// commands that write to it and on the changes reported from outside.
+// Only for fully synchronous calls, which do not spin an event loop.
+class InFlightQueries
+{
+public:
+    typedef std::function<Utils::SynchronousProcessResponse()> Query;
+
+    InFlightQueries();
+
+    // topLevel is the checkout the query runs in, which its result is kept for.
+    Utils::SynchronousProcessResponse run(const QString &workingDirectory, const QString &topLevel,
+                                          const QStringList &args, unsigned flags,
+                                          const Query &query, bool *merged = nullptr);
+    // Drops the kept results of a checkout, or all of them if topLevel is empty.
+    void invalidate(const QString &topLevel = QString());
+
+    int inFlightCount() const;
+    int waiterCount() const;
+    int resultCount() const;
+
+    static bool isReadOnly(const QStringList &args);
+
+    static const int resultTtlMs = 2000;
+
+private:
+    struct Entry;
+    struct Result
+    {
+        QString topLevel;
+        Utils::SynchronousProcessResponse response;
+        qint64 expiresMs;
+    };
+
+    mutable QMutex m_mutex;
+    QHash<QString, QSharedPointer<Entry>> m_entries;
+    QHash<QString, Result> m_results;
+    QElapsedTimer m_clock;
+    quint64 m_generation = 0;
+};
+
+} // namespace Internal
+} // namespace Fossil
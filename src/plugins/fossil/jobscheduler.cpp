@@ -0,0 +1,172 @@
+/**************************************************************************
+**  This file is part of Fossil VCS plugin for Qt Creator
+**
+**  Copyright (c) 2013 - 2017, Artur Shepilko, <qtc-fossil@nomadbyte.com>.
+**
+**  Based on Bazaar VCS plugin for Qt Creator by Hugues Delorme.
+**
+**  Permission is hereby granted, free of charge, to any person obtaining a copy
+**  of this software and associated documentation files (the "Software"), to deal
+**  in the Software without restriction, including without limitation the rights
+**  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+**  copies of the Software, and to permit persons to whom the Software is
+**  furnished to do so, subject to the following conditions:
+**
+**  The above copyright notice and this permission notice shall be included in
+**  all copies or substantial portions of the Software.
+**
+**  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+**  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+**  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+**  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+**  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+**  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+**  THE SOFTWARE.
+**************************************************************************/
+
+#include "jobscheduler.h"
+
+#include <vcsbase/vcscommand.h>
+
+#include <utils/qtcassert.h>
+
+#include <QSharedPointer>
+
+namespace Fossil {
+namespace Internal {
+
+JobScheduler::JobScheduler(QObject *parent) :
+    QObject(parent)
+{
+    m_clock.start();
+}
+
+int JobScheduler::maxRunningPerRepository() const
+{
+    return m_maxRunning;
+}
+
+void JobScheduler::setMaxRunningPerRepository(int maxRunning)
+{
+    m_maxRunning = qMax(1, maxRunning);
+    for (const QString &repository : m_repositories.keys())
+        dispatch(repository);
+}
+
+int JobScheduler::agingInterval() const
+{
+    return m_agingIntervalMs;
+}
+
+void JobScheduler::setAgingInterval(int intervalMs)
+{
+    m_agingIntervalMs = qMax(1, intervalMs);
+}
+
+void JobScheduler::schedule(const QString &repository, Priority priority,
+                            VcsBase::VcsCommand *command, const std::function<void()> &start)
+{
+    QTC_ASSERT(command, return);
+
+    QList<Job> &pending = m_repositories[repository].pending;
+    int index = pending.size();
+    while (index > 0 && pending.at(index - 1).priority > priority)
+        --index;
+    pending.insert(index, {command, start, priority, m_clock.elapsed()});
+
+    dispatch(repository);
+}
+
+bool JobScheduler::cancel(VcsBase::VcsCommand *command)
+{
+    for (auto it = m_repositories.begin(); it != m_repositories.end(); ++it) {
+        QList<Job> &pending = it->pending;
+        for (int i = 0; i < pending.size(); ++i) {
+            if (pending.at(i).command != command)
+                continue;
+            pending.removeAt(i);
+            if (it->running == 0 && pending.isEmpty())
+                m_repositories.erase(it);
+            // Its issuer is waiting for it to finish, as it would after running
+            emit command->finished(false, -1, command->cookie());
+            command->deleteLater();
+            return true;
+        }
+    }
+    return false;
+}
+
+int JobScheduler::runningCount(const QString &repository) const
+{
+    return m_repositories.value(repository).running;
+}
+
+int JobScheduler::pendingCount(const QString &repository) const
+{
+    return m_repositories.value(repository).pending.size();
+}
+
+void JobScheduler::dispatch(const QString &repository)
+{
+    auto it = m_repositories.find(repository);
+    if (it == m_repositories.end())
+        return;
+
+    while (it->running < m_maxRunning && !it->pending.isEmpty()) {
+        const Job job = it->pending.takeAt(nextJob(it->pending));
+        if (!job.command)
+            continue;
+
+        ++it->running;
+        // A command deleted without finishing frees its slot as well
+        QSharedPointer<bool> done(new bool(false));
+        const auto release = [this, repository, done]() {
+            if (*done)
+                return;
+            *done = true;
+            jobDone(repository);
+        };
+        connect(job.command.data(), &VcsBase::VcsCommand::finished, this, release);
+        connect(job.command.data(), &QObject::destroyed, this, release);
+        job.start();
+
+        // start() may have re-entered
+        it = m_repositories.find(repository);
+        if (it == m_repositories.end())
+            return;
+    }
+
+    if (it->running == 0 && it->pending.isEmpty())
+        m_repositories.erase(it);
+}
+
+int JobScheduler::nextJob(const QList<Job> &pending) const
+{
+    // The pending jobs are ordered by priority, then by the time they were
+    // scheduled. Of the jobs of the same aged priority the longest waiting starts.
+    const qint64 now = m_clock.elapsed();
+    int next = 0;
+    qint64 nextPriority = 0;
+    for (int i = 0; i < pending.size(); ++i) {
+        const Job &job = pending.at(i);
+        const qint64 priority = qMax(qint64(Interactive),
+                                     job.priority - (now - job.scheduledMs) / m_agingIntervalMs);
+        if (i == 0 || priority < nextPriority
+                || (priority == nextPriority && job.scheduledMs < pending.at(next).scheduledMs)) {
+            next = i;
+            nextPriority = priority;
+        }
+    }
+    return next;
+}
+
+void JobScheduler::jobDone(const QString &repository)
+{
+    auto it = m_repositories.find(repository);
+    QTC_ASSERT(it != m_repositories.end() && it->running > 0, return);
+    --it->running;
+    dispatch(repository);
+}
+
+} // namespace Internal
+} // namespace Fossil
@@ -0,0 +1,107 @@
+/**************************************************************************
+**  This file is part of Fossil VCS plugin for Qt Creator
+**
+**  Copyright (c) 2013 - 2017, Artur Shepilko, <qtc-fossil@nomadbyte.com>.
+**
+**  Based on Bazaar VCS plugin for Qt Creator by Hugues Delorme.
+**
+**  Permission is hereby granted, free of charge, to any person obtaining a copy
+**  of this software and associated documentation files (the "Software"), to deal
+**  in the Software without restriction, including without limitation the rights
+**  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+**  copies of the Software, and to permit persons to whom the Software is
+**  furnished to do so, subject to the following conditions:
+**
+**  The above copyright notice and this permission notice shall be included in
+**  all copies or substantial portions of the Software.
+**
+**  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+**  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+**  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+**  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+**  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+**  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+**  THE SOFTWARE.
+**************************************************************************/
+
+#pragma once
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <QPointer>
+
+#include <functional>
+
+namespace VcsBase { class VcsCommand; }
+
+namespace Fossil {
+namespace Internal {
+
+// Starts the asynchronous fossil commands of each repository in order of
+// priority, at most maxRunningPerRepository() at once, so that concurrent
+// commands do not contend for the repository lock. Commands waiting to start
+// are overtaken by later ones of a higher priority; running ones are not
+// interrupted. Commands of one priority start in the order they were scheduled.
+// A command moves up one priority for each aging interval it waits, so that
+// a steady stream of the user's commands does not starve the background ones.
+class JobScheduler : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum Priority {
+        Interactive,    // the user is waiting on the result: annotate, describe, status
+        Normal,         // other commands of the user: timeline, commit, pull
+        Background      // status polling, prefetching, scheduled pulls, Sync All
+    };
+
+    explicit JobScheduler(QObject *parent = nullptr);
+
+    int maxRunningPerRepository() const;
+    void setMaxRunningPerRepository(int maxRunning);
+    int agingInterval() const;
+    void setAgingInterval(int intervalMs);
+
+    // Calls start(), which is to execute the command, once the repository has a free slot.
+    void schedule(const QString &repository, Priority priority,
+                  VcsBase::VcsCommand *command, const std::function<void()> &start);
+    // Drops a command that has not been started yet: it finishes unsuccessfully
+    // and is deleted. Returns false if it is not waiting, that is, when it is
+    // already running.
+    bool cancel(VcsBase::VcsCommand *command);
+
+    int runningCount(const QString &repository) const;
+    int pendingCount(const QString &repository) const;
+
+    static const int defaultMaxRunningPerRepository = 2;
+    static const int defaultAgingIntervalMs = 10000;
+
+private:
+    struct Job
+    {
+        QPointer<VcsBase::VcsCommand> command;
+        std::function<void()> start;
+        Priority priority;
+        qint64 scheduledMs;
+    };
+
+    struct Repository
+    {
+        QList<Job> pending;
+        int running = 0;
+    };
+
+    void dispatch(const QString &repository);
+    void jobDone(const QString &repository);
+    int nextJob(const QList<Job> &pending) const;
+
+    QHash<QString, Repository> m_repositories;
+    int m_maxRunning = defaultMaxRunningPerRepository;
+    int m_agingIntervalMs = defaultAgingIntervalMs;
+    QElapsedTimer m_clock;
+};
+
+} // namespace Internal
+} // namespace Fossil
@@ -0,0 +1,70 @@
+/**************************************************************************
+**  This file is part of Fossil VCS plugin for Qt Creator
+**
+**  Copyright (c) 2013 - 2017, Artur Shepilko, <qtc-fossil@nomadbyte.com>.
+**
+**  Based on Bazaar VCS plugin for Qt Creator by Hugues Delorme.
+**
+**  Permission is hereby granted, free of charge, to any person obtaining a copy
+**  of this software and associated documentation files (the "Software"), to deal
+**  in the Software without restriction, including without limitation the rights
+**  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+**  copies of the Software, and to permit persons to whom the Software is
+**  furnished to do so, subject to the following conditions:
+**
+**  The above copyright notice and this permission notice shall be included in
+**  all copies or substantial portions of the Software.
+**
+**  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+**  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+**  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+**  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+**  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+**  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+**  THE SOFTWARE.
+**************************************************************************/
+
+#include "loghighlighter.h"
+#include "constants.h"
+
+#include <utils/qtcassert.h>
+
+namespace Fossil {
+namespace Internal {
+
+FossilLogHighlighter::FossilLogHighlighter(QTextDocument * parent) :
+    QSyntaxHighlighter(parent),
+    m_revisionIdRx(Constants::CHANGESET_ID),
+    m_dateRx("([0-9]{4}-[0-9]{2}-[0-9]{2})")
+{
+    QTC_CHECK(m_revisionIdRx.isValid());
+    QTC_CHECK(m_dateRx.isValid());
+}
+
+void FossilLogHighlighter::highlightBlock(const QString &text)
+{
+    // Match the revision-ids and dates -- highlight them for convenience.
+
+    // Format revision-ids
+    QRegularExpressionMatchIterator i = m_revisionIdRx.globalMatch(text);
+    while (i.hasNext()) {
+        const QRegularExpressionMatch revisionIdMatch = i.next();
+        QTextCharFormat charFormat = format(0);
+        charFormat.setForeground(Qt::darkBlue);
+        //charFormat.setFontItalic(true);
+        setFormat(revisionIdMatch.capturedStart(0), revisionIdMatch.capturedLength(0), charFormat);
+    }
+
+    // Format dates
+    i = m_dateRx.globalMatch(text);
+    while (i.hasNext()) {
+        const QRegularExpressionMatch dateMatch = i.next();
+        QTextCharFormat charFormat = format(0);
+        charFormat.setForeground(Qt::darkBlue);
+        charFormat.setFontWeight(QFont::DemiBold);
+        setFormat(dateMatch.capturedStart(0), dateMatch.capturedLength(0), charFormat);
+    }
+}
+
+} // namespace Internal
+} // namespace Fossil
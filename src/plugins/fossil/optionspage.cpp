@@ -63,6 +63,11 @@ VcsBase::VcsBaseClientSettings OptionsPageWidget::settings() const
     s.setValue(FossilSettings::timelineWidthKey, m_ui.logEntriesWidth->value());
     s.setValue(FossilSettings::timeoutKey, m_ui.timeout->value());
     s.setValue(FossilSettings::disableAutosyncKey, m_ui.disableAutosyncCheckBox->isChecked());
+    s.setValue(FossilSettings::incrementalStatusKey, m_ui.incrementalStatusCheckBox->isChecked());
+    s.setValue(FossilSettings::syncConcurrencyKey, m_ui.syncConcurrency->value());
+    s.setValue(FossilSettings::backgroundPullIntervalKey, m_ui.backgroundPullInterval->value());
+    s.setValue(FossilSettings::syncProxyKey, m_ui.syncProxyCheckBox->isChecked());
+    s.setValue(FossilSettings::repositoryTemplatesKey, m_ui.repositoryTemplates->value());
     return s;
 }
 
@@ -76,6 +81,11 @@ void OptionsPageWidget::setSettings(const VcsBase::VcsBaseClientSettings &s)
     m_ui.logEntriesWidth->setValue(s.intValue(FossilSettings::timelineWidthKey));
     m_ui.timeout->setValue(s.intValue(FossilSettings::timeoutKey));
     m_ui.disableAutosyncCheckBox->setChecked(s.boolValue(FossilSettings::disableAutosyncKey));
+    m_ui.incrementalStatusCheckBox->setChecked(s.boolValue(FossilSettings::incrementalStatusKey));
+    m_ui.syncConcurrency->setValue(s.intValue(FossilSettings::syncConcurrencyKey));
+    m_ui.backgroundPullInterval->setValue(s.intValue(FossilSettings::backgroundPullIntervalKey));
+    m_ui.syncProxyCheckBox->setChecked(s.boolValue(FossilSettings::syncProxyKey));
+    m_ui.repositoryTemplates->setValue(s.intValue(FossilSettings::repositoryTemplatesKey));
 }
 
 OptionsPage::OptionsPage(Core::IVersionControl *control) :
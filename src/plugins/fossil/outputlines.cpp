@@ -0,0 +1,70 @@
+/**************************************************************************
+**  This file is part of Fossil VCS plugin for Qt Creator
+**
+**  Copyright (c) 2013 - 2017, Artur Shepilko, <qtc-fossil@nomadbyte.com>.
+**
+**  Based on Bazaar VCS plugin for Qt Creator by Hugues Delorme.
+**
+**  Permission is hereby granted, free of charge, to any person obtaining a copy
+**  of this software and associated documentation files (the "Software"), to deal
+**  in the Software without restriction, including without limitation the rights
+**  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+**  copies of the Software, and to permit persons to whom the Software is
+**  furnished to do so, subject to the following conditions:
+**
+**  The above copyright notice and this permission notice shall be included in
+**  all copies or substantial portions of the Software.
+**
+**  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+**  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+**  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+**  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+**  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+**  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+**  THE SOFTWARE.
+**************************************************************************/
+
+#include "outputlines.h"
+
+namespace Fossil {
+namespace Internal {
+
+OutputLines::const_iterator::const_iterator(const QString *output, int next) :
+    m_output(output),
+    m_next(next)
+{
+    if (m_next != -1)
+        advance();
+}
+
+void OutputLines::const_iterator::advance()
+{
+    const int size = m_output->size();
+    while (m_next != -1 && m_next < size) {
+        int end = m_output->indexOf('\n', m_next);
+        if (end == -1)
+            end = size;
+
+        int lineEnd = end;
+        while (lineEnd > m_next && m_output->at(lineEnd - 1) == '\r')
+            --lineEnd;
+        const QStringRef line = m_output->midRef(m_next, lineEnd - m_next);
+        m_next = end + 1;
+        if (!line.trimmed().isEmpty()) {
+            m_line = line;
+            return;
+        }
+    }
+
+    m_next = -1;
+    m_line = QStringRef();
+}
+
+QString OutputLines::firstLine() const
+{
+    const const_iterator it = begin();
+    return (it != end() ? it->trimmed().toString() : QString());
+}
+
+} // namespace Internal
+} // namespace Fossil
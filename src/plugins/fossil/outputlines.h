@@ -0,0 +1,75 @@
+/**************************************************************************
+**  This file is part of Fossil VCS plugin for Qt Creator
+**
+**  Copyright (c) 2013 - 2017, Artur Shepilko, <qtc-fossil@nomadbyte.com>.
+**
+**  Based on Bazaar VCS plugin for Qt Creator by Hugues Delorme.
+**
+**  Permission is hereby granted, free of charge, to any person obtaining a copy
+**  of this software and associated documentation files (the "Software"), to deal
+**  in the Software without restriction, including without limitation the rights
+**  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+**  copies of the Software, and to permit persons to whom the Software is
+**  furnished to do so, subject to the following conditions:
+**
+**  The above copyright notice and this permission notice shall be included in
+**  all copies or substantial portions of the Software.
+**
+**  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+**  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+**  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+**  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+**  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+**  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+**  THE SOFTWARE.
+**************************************************************************/
+
+#pragma once
+
+#include <QString>
+#include <QStringRef>
+
+namespace Fossil {
+namespace Internal {
+
+// Iterates over the lines of a fossil client output without copying it.
+// The lines are returned as they are, less the extraneous '\r' added by the
+// Windows client; blank lines are skipped. firstLine() is trimmed.
+//
+//   for (const QStringRef &line : OutputLines(response.stdOut())) { ... }
+class OutputLines
+{
+public:
+    class const_iterator
+    {
+    public:
+        const QStringRef &operator*() const { return m_line; }
+        const QStringRef *operator->() const { return &m_line; }
+        const_iterator &operator++() { advance(); return *this; }
+        bool operator==(const const_iterator &other) const { return m_next == other.m_next; }
+        bool operator!=(const const_iterator &other) const { return m_next != other.m_next; }
+
+    private:
+        friend class OutputLines;
+        const_iterator(const QString *output, int next);
+        void advance();
+
+        const QString *m_output;
+        int m_next;
+        QStringRef m_line;
+    };
+
+    // The output is held as an implicitly shared copy, so it is safe to pass a temporary.
+    explicit OutputLines(const QString &output) : m_output(output) { }
+
+    const_iterator begin() const { return const_iterator(&m_output, 0); }
+    const_iterator end() const { return const_iterator(&m_output, -1); }
+
+    QString firstLine() const;
+
+private:
+    const QString m_output;
+};
+
+} // namespace Internal
+} // namespace Fossil
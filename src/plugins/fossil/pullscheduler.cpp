@@ -0,0 +1,256 @@
+/**************************************************************************
+**  This file is part of Fossil VCS plugin for Qt Creator
+**
+**  Copyright (c) 2013 - 2017, Artur Shepilko, <qtc-fossil@nomadbyte.com>.
+**
+**  Based on Bazaar VCS plugin for Qt Creator by Hugues Delorme.
+**
+**  Permission is hereby granted, free of charge, to any person obtaining a copy
+**  of this software and associated documentation files (the "Software"), to deal
+**  in the Software without restriction, including without limitation the rights
+**  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+**  copies of the Software, and to permit persons to whom the Software is
+**  furnished to do so, subject to the following conditions:
+**
+**  The above copyright notice and this permission notice shall be included in
+**  all copies or substantial portions of the Software.
+**
+**  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+**  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+**  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+**  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+**  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+**  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+**  THE SOFTWARE.
+**************************************************************************/
+
+#include "pullscheduler.h"
+#include "commandstatistics.h"
+#include "fossilclient.h"
+#include "jobscheduler.h"
+#include "outputlines.h"
+#include "syncprogressparser.h"
+
+#include <projectexplorer/buildmanager.h>
+
+#include <vcsbase/vcscommand.h>
+#include <vcsbase/vcsoutputwindow.h>
+
+#include <utils/qtcassert.h>
+
+#include <QDir>
+#include <QRegularExpression>
+#include <QSharedPointer>
+
+namespace Fossil {
+namespace Internal {
+
+// How often the schedule is checked, independently of the pull interval.
+static const int tickIntervalMs = 30 * 1000;
+// Failing repositories are retried at most this many intervals apart.
+static const int maxBackoffFactor = 16;
+
+PullScheduler::PullScheduler(FossilClient *client, const RepositoryProvider &repositoryProvider,
+                             QObject *parent) :
+    QObject(parent),
+    m_client(client),
+    m_repositoryProvider(repositoryProvider)
+{
+    QTC_CHECK(m_client);
+    m_clock.start();
+    m_timer.setInterval(tickIntervalMs);
+    connect(&m_timer, &QTimer::timeout, this, &PullScheduler::tick);
+}
+
+void PullScheduler::setInterval(int minutes)
+{
+    const qint64 intervalMs = qMax(0, minutes) * 60 * 1000;
+    if (intervalMs == m_intervalMs)
+        return;
+
+    m_intervalMs = intervalMs;
+    m_repositories.clear();
+    if (m_intervalMs > 0)
+        m_timer.start();
+    else
+        m_timer.stop();
+}
+
+int PullScheduler::interval() const
+{
+    return int(m_intervalMs / 60 / 1000);
+}
+
+bool PullScheduler::isPulling() const
+{
+    return !m_pulling.isEmpty();
+}
+
+int PullScheduler::failures(const QString &repository) const
+{
+    return m_repositories.value(repository).failures;
+}
+
+int PullScheduler::newCheckins(const QString &repository) const
+{
+    return m_repositories.value(repository).newCheckins;
+}
+
+qint64 PullScheduler::backoffDelayMs(qint64 intervalMs, int failures)
+{
+    qint64 factor = 1;
+    for (int i = 0; i < failures && factor < maxBackoffFactor; ++i)
+        factor *= 2;
+    return intervalMs * factor;
+}
+
+void PullScheduler::tick()
+{
+    if (m_intervalMs <= 0 || isBusy())
+        return;
+
+    const qint64 now = m_clock.elapsed();
+    for (const QString &repository : m_repositoryProvider()) {
+        // Newly opened repositories are pulled right away.
+        auto it = m_repositories.find(repository);
+        if (it == m_repositories.end()) {
+            it = m_repositories.insert(repository, RepositoryState());
+            it->nextPullMs = now;
+        }
+        if (it->nextPullMs <= now && !isBusy(repository)) {
+            pull(repository);
+            return;
+        }
+    }
+}
+
+bool PullScheduler::isBusy() const
+{
+    // Stay out of the way of builds, network and disk are better spent there.
+    return isPulling() || ProjectExplorer::BuildManager::isBuilding();
+}
+
+bool PullScheduler::isBusy(const QString &repository) const
+{
+    // Commands of the user (annotate, commit, ...) hold the repository lock
+    // a pull would contend for, such a repository is tried again next tick.
+    const JobScheduler *jobScheduler = m_client->jobScheduler();
+    return jobScheduler->runningCount(repository) > 0 || jobScheduler->pendingCount(repository) > 0;
+}
+
+void PullScheduler::pull(const QString &repository)
+{
+    QTC_ASSERT(!isPulling(), return);
+    m_pulling = repository;
+
+    // Runs unattended: no SSH password prompts and no output unless it fails.
+    QSharedPointer<SyncProgress> progress(new SyncProgress);
+    VcsBase::VcsCommand *command = m_client->createSyncCommand(repository, progress);
+    command->addFlags(VcsBase::VcsCommand::SuppressCommandLogging);
+    command->addJob(m_client->vcsBinary(), m_client->syncArguments(repository, "pull"),
+                    m_client->vcsTimeoutS());
+    m_client->commandStatistics()->instrument(command, "pull", repository);
+    track(command, repository, [this, repository](bool ok) { pullDone(repository, ok); });
+    m_client->jobScheduler()->schedule(repository, JobScheduler::Background, command,
+                                       [command]() { command->execute(); });
+}
+
+void PullScheduler::track(VcsBase::VcsCommand *command, const QString &repository,
+                          const std::function<void(bool)> &done)
+{
+    // A command deleted without finishing ends the pull as well,
+    // the repository is tried again at its next scheduled time.
+    QSharedPointer<bool> finished(new bool(false));
+    connect(command, &VcsBase::VcsCommand::finished, this, [finished, done](bool ok) {
+        *finished = true;
+        done(ok);
+    });
+    connect(command, &QObject::destroyed, this, [this, repository, finished]() {
+        if (!*finished)
+            finishPull(repository, false, newCheckins(repository));
+    });
+}
+
+void PullScheduler::pullDone(const QString &repository, bool ok)
+{
+    RepositoryState &state = m_repositories[repository];
+    const qint64 now = m_clock.elapsed();
+    if (!ok) {
+        ++state.failures;
+        const qint64 delayMs = backoffDelayMs(m_intervalMs, state.failures);
+        state.nextPullMs = now + delayMs;
+        VcsBase::VcsOutputWindow::appendSilently(
+                    tr("Background pull of %1 failed, retrying in %2 minutes.")
+                    .arg(QDir::toNativeSeparators(repository))
+                    .arg(delayMs / 60 / 1000));
+        finishPull(repository, false, state.newCheckins);
+        return;
+    }
+
+    state.failures = 0;
+    state.nextPullMs = now + m_intervalMs;
+    emit m_client->changed(QVariant(repository));
+    countNewCheckins(repository);
+}
+
+void PullScheduler::countNewCheckins(const QString &repository)
+{
+    // Count the descendants of the checked out version on its own branch, as
+    // told by their branch tags; the check-ins of other branches are not for
+    // an update. The descendants include the version itself.
+    static const char newCheckinsSql[] =
+            "WITH RECURSIVE"
+            " checkout(rid) AS (SELECT CAST(value AS INTEGER) FROM localdb.vvar WHERE name = 'checkout'),"
+            " branchtag(tagid) AS (SELECT tagid FROM repository.tag WHERE tagname = 'branch'),"
+            " branch(name) AS (SELECT value FROM repository.tagxref"
+            "  WHERE rid = (SELECT rid FROM checkout) AND tagid = (SELECT tagid FROM branchtag)"
+            "  AND tagtype > 0),"
+            " descendant(rid) AS (SELECT rid FROM checkout"
+            "  UNION SELECT plink.cid FROM repository.plink"
+            "  JOIN descendant ON plink.pid = descendant.rid"
+            "  JOIN repository.tagxref ON tagxref.rid = plink.cid"
+            "  WHERE tagxref.tagid = (SELECT tagid FROM branchtag) AND tagxref.tagtype > 0"
+            "  AND tagxref.value = (SELECT name FROM branch))"
+            " SELECT count(*) - 1, 'new-checkins-end' FROM descendant;";
+    static const QRegularExpression countRx("^(\\d+)\\|new-checkins-end$");
+    QSharedPointer<int> count(new int(-1));
+
+    VcsBase::VcsCommand *command = m_client->createCommand(repository);
+    command->addFlags(VcsBase::VcsCommand::NoOutput);
+    connect(command, &VcsBase::VcsCommand::stdOutText, this, [count](const QString &text) {
+        for (const QStringRef &line : OutputLines(text)) {
+            const QRegularExpressionMatch match = countRx.match(line);
+            if (match.hasMatch())
+                *count = match.captured(1).toInt();
+        }
+    });
+    // Without the end marker the count is not known, e.g. with fossil versions
+    // that have no recursive queries, and the previous one is kept.
+    track(command, repository, [this, repository, count](bool ok) {
+        finishPull(repository, true, (ok && *count >= 0) ? *count : newCheckins(repository));
+    });
+    command->addJob(m_client->vcsBinary(), {"sql", newCheckinsSql}, m_client->vcsTimeoutS());
+    m_client->commandStatistics()->instrument(command, "sql", repository);
+    m_client->jobScheduler()->schedule(repository, JobScheduler::Background, command,
+                                       [command]() { command->execute(); });
+}
+
+void PullScheduler::finishPull(const QString &repository, bool ok, int newCheckins)
+{
+    RepositoryState &state = m_repositories[repository];
+    if (state.newCheckins != newCheckins) {
+        state.newCheckins = newCheckins;
+        if (newCheckins > 0) {
+            VcsBase::VcsOutputWindow::appendSilently(
+                        tr("%n new check-ins upstream in %1.", 0, newCheckins)
+                        .arg(QDir::toNativeSeparators(repository)));
+        }
+        emit newCheckinsChanged(repository, newCheckins);
+    }
+
+    m_pulling.clear();
+    emit pullFinished(repository, ok);
+}
+
+} // namespace Internal
+} // namespace Fossil
@@ -0,0 +1,101 @@
+/**************************************************************************
+**  This file is part of Fossil VCS plugin for Qt Creator
+**
+**  Copyright (c) 2013 - 2017, Artur Shepilko, <qtc-fossil@nomadbyte.com>.
+**
+**  Based on Bazaar VCS plugin for Qt Creator by Hugues Delorme.
+**
+**  Permission is hereby granted, free of charge, to any person obtaining a copy
+**  of this software and associated documentation files (the "Software"), to deal
+**  in the Software without restriction, including without limitation the rights
+**  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+**  copies of the Software, and to permit persons to whom the Software is
+**  furnished to do so, subject to the following conditions:
+**
+**  The above copyright notice and this permission notice shall be included in
+**  all copies or substantial portions of the Software.
+**
+**  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+**  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+**  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+**  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+**  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+**  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+**  THE SOFTWARE.
+**************************************************************************/
+
+#pragma once
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QObject>
+#include <QStringList>
+#include <QTimer>
+
+#include <functional>
+
+namespace VcsBase { class VcsCommand; }
+
+namespace Fossil {
+namespace Internal {
+
+class FossilClient;
+
+// Pulls the open repositories in the background, one at a time, every
+// interval minutes. Failed pulls are retried with an exponential backoff.
+// After each successful pull the check-ins on the branch of the checkout
+// that are not in the checkout yet are counted and published.
+class PullScheduler : public QObject
+{
+    Q_OBJECT
+
+public:
+    typedef std::function<QStringList()> RepositoryProvider;
+
+    PullScheduler(FossilClient *client, const RepositoryProvider &repositoryProvider,
+                  QObject *parent = nullptr);
+
+    // Pull interval in minutes, 0 disables the scheduler.
+    void setInterval(int minutes);
+    int interval() const;
+
+    bool isPulling() const;
+    int failures(const QString &repository) const;
+    int newCheckins(const QString &repository) const;
+
+    void pull(const QString &repository);
+
+    static qint64 backoffDelayMs(qint64 intervalMs, int failures);
+
+signals:
+    void pullFinished(const QString &repository, bool ok);
+    void newCheckinsChanged(const QString &repository, int count);
+
+private:
+    struct RepositoryState
+    {
+        qint64 nextPullMs = 0;
+        int failures = 0;
+        int newCheckins = 0;
+    };
+
+    void tick();
+    bool isBusy() const;
+    bool isBusy(const QString &repository) const;
+    void track(VcsBase::VcsCommand *command, const QString &repository,
+               const std::function<void(bool)> &done);
+    void pullDone(const QString &repository, bool ok);
+    void countNewCheckins(const QString &repository);
+    void finishPull(const QString &repository, bool ok, int newCheckins);
+
+    FossilClient *const m_client;
+    const RepositoryProvider m_repositoryProvider;
+    QHash<QString, RepositoryState> m_repositories;
+    QString m_pulling;
+    QTimer m_timer;
+    QElapsedTimer m_clock;
+    qint64 m_intervalMs = 0;
+};
+
+} // namespace Internal
+} // namespace Fossil
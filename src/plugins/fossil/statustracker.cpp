@@ -0,0 +1,265 @@
+/**************************************************************************
+**  This file is part of Fossil VCS plugin for Qt Creator
+**
+**  Copyright (c) 2013 - 2017, Artur Shepilko, <qtc-fossil@nomadbyte.com>.
+**
+**  Based on Bazaar VCS plugin for Qt Creator by Hugues Delorme.
+**
+**  Permission is hereby granted, free of charge, to any person obtaining a copy
+**  of this software and associated documentation files (the "Software"), to deal
+**  in the Software without restriction, including without limitation the rights
+**  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+**  copies of the Software, and to permit persons to whom the Software is
+**  furnished to do so, subject to the following conditions:
+**
+**  The above copyright notice and this permission notice shall be included in
+**  all copies or substantial portions of the Software.
+**
+**  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+**  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+**  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+**  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+**  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+**  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+**  THE SOFTWARE.
+**************************************************************************/
+
+#include "statustracker.h"
+#include "constants.h"
+
+#include <utils/filesystemwatcher.h>
+#include <utils/qtcassert.h>
+
+#include <QDateTime>
+#include <QDir>
+#include <QFileInfo>
+
+namespace Fossil {
+namespace Internal {
+
+// Fossil itself updates the checkout db-file when scanning for changes,
+// ignore such self-inflicted notifications for a little while.
+static const qint64 scanSettleTimeMs = 1000;
+
+static QString checkoutFilePath(const QString &topLevel)
+{
+    return topLevel + '/' + Constants::FOSSILREPO;
+}
+
+StatusTracker::StatusTracker(QObject *parent) : QObject(parent),
+    m_watcher(new Utils::FileSystemWatcher(this))
+{
+    connect(m_watcher, &Utils::FileSystemWatcher::fileChanged,
+            this, &StatusTracker::checkoutFileChanged);
+}
+
+bool StatusTracker::hasBaseline(const QString &topLevel) const
+{
+    auto it = m_checkouts.constFind(topLevel);
+    return it != m_checkouts.constEnd() && it->baseline;
+}
+
+QStringList StatusTracker::dirtyFiles(const QString &topLevel) const
+{
+    auto it = m_checkouts.constFind(topLevel);
+    if (it == m_checkouts.constEnd())
+        return QStringList();
+
+    QStringList files = it->dirty.keys();
+    std::sort(files.begin(), files.end());
+    return files;
+}
+
+QList<StatusTracker::StatusItem> StatusTracker::status(const QString &topLevel) const
+{
+    auto it = m_checkouts.constFind(topLevel);
+    if (it == m_checkouts.constEnd())
+        return QList<StatusItem>();
+
+    return it->items.values();
+}
+
+void StatusTracker::setBaseline(const QString &topLevel, const QList<StatusItem> &status,
+                                quint64 scanGeneration, const FileStamps &stamps)
+{
+    QTC_ASSERT(!topLevel.isEmpty(), return);
+
+    Checkout &checkout = m_checkouts[topLevel];
+    checkout.stamps = stamps;
+    checkout.items.clear();
+    for (const StatusItem &item : status)
+        checkout.items.insert(itemPath(item), item);
+    for (const QString &file : checkout.dirty.keys())
+        clearScanned(checkout, file, scanGeneration);
+    checkout.baseline = true;
+
+    const QString checkoutFile = checkoutFilePath(topLevel);
+    if (!m_watcher->watchesFile(checkoutFile))
+        m_watcher->addFile(checkoutFile, Utils::FileSystemWatcher::WatchAllChanges);
+}
+
+void StatusTracker::updateBaseline(const QString &topLevel, const QStringList &checkedFiles,
+                                   const QList<StatusItem> &status, quint64 scanGeneration)
+{
+    // Invalidated while scanning, the next request scans it fully
+    auto it = m_checkouts.find(topLevel);
+    if (it == m_checkouts.end() || !it->baseline)
+        return;
+
+    // Files not reported back are unchanged by now.
+    for (const QString &file : checkedFiles) {
+        it->items.remove(file);
+        clearScanned(*it, file, scanGeneration);
+    }
+    for (const StatusItem &item : status) {
+        const QString path = itemPath(item);
+        it->items.insert(path, item);
+        clearScanned(*it, path, scanGeneration);
+    }
+}
+
+quint64 StatusTracker::beginScan(const QString &topLevel)
+{
+    // The first full scan creates the entry, so that the db-file changes
+    // of its own are ignored as well.
+    Checkout &checkout = m_checkouts[topLevel];
+    ++checkout.scanning;
+    return checkout.generation++;
+}
+
+void StatusTracker::endScan(const QString &topLevel)
+{
+    auto it = m_checkouts.find(topLevel);
+    if (it == m_checkouts.end())
+        return;
+
+    if (it->scanning > 0)
+        --it->scanning;
+    it->ignoreChangesUntil = QDateTime::currentMSecsSinceEpoch() + scanSettleTimeMs;
+}
+
+StatusTracker::FileStamps StatusTracker::stampFiles(const QString &topLevel)
+{
+    // Nested checkouts are tracked on their own, symbolic links to
+    // directories are not followed.
+    FileStamps stamps;
+    QStringList directories(topLevel);
+    while (!directories.isEmpty()) {
+        const QString directory = directories.takeLast();
+        const QFileInfoList entries = QDir(directory).entryInfoList(
+                    QDir::Files | QDir::Dirs | QDir::Hidden | QDir::System | QDir::NoDotAndDotDot);
+        for (const QFileInfo &entry : entries) {
+            const QString path = entry.filePath();
+            if (entry.isDir()) {
+                if (!entry.isSymLink() && !QFileInfo::exists(path + '/' + Constants::FOSSILREPO))
+                    directories.append(path);
+                continue;
+            }
+            const QString relativePath = path.mid(topLevel.size() + 1);
+            if (relativePath.startsWith(QLatin1String(Constants::FOSSILREPO)))
+                continue;
+            FileStamp &stamp = stamps[relativePath];
+            stamp.modified = entry.lastModified().toMSecsSinceEpoch();
+            stamp.size = entry.size();
+        }
+    }
+    return stamps;
+}
+
+void StatusTracker::markChangedFiles(const QString &topLevel, const FileStamps &stamps)
+{
+    auto it = m_checkouts.find(topLevel);
+    if (it == m_checkouts.end() || !it->baseline)
+        return;
+
+    // Files that appeared since are not tracked yet; adding them
+    // changes the checkout file, which invalidates the baseline.
+    for (auto old = it->stamps.constBegin(); old != it->stamps.constEnd(); ++old) {
+        const auto stamp = stamps.constFind(old.key());
+        if (stamp == stamps.constEnd()
+                || stamp->modified != old->modified || stamp->size != old->size) {
+            it->dirty.insert(old.key(), it->generation);
+        }
+    }
+    it->stamps = stamps;
+}
+
+void StatusTracker::markFileDirty(const QString &file)
+{
+    const QString topLevel = topLevelOf(file);
+    if (topLevel.isEmpty())
+        return;
+
+    const QString relativePath = file.mid(topLevel.size() + 1);
+    if (relativePath.isEmpty() || relativePath == Constants::FOSSILREPO)
+        return;
+
+    Checkout &checkout = m_checkouts[topLevel];
+    checkout.dirty.insert(relativePath, checkout.generation);
+}
+
+void StatusTracker::markFilesDirty(const QStringList &files)
+{
+    for (const QString &file : files)
+        markFileDirty(file);
+}
+
+void StatusTracker::invalidate(const QString &repository)
+{
+    const QString topLevel = QDir::fromNativeSeparators(repository);
+    if (!m_checkouts.remove(topLevel))
+        return;
+
+    const QString checkoutFile = checkoutFilePath(topLevel);
+    if (m_watcher->watchesFile(checkoutFile))
+        m_watcher->removeFile(checkoutFile);
+}
+
+void StatusTracker::checkoutFileChanged(const QString &checkoutFile)
+{
+    // The checkout was changed outside of the tracked files
+    // (commit, update, revert from a terminal); rescan it fully next time.
+    const QString topLevel = QFileInfo(checkoutFile).absolutePath();
+    auto it = m_checkouts.constFind(topLevel);
+    if (it == m_checkouts.constEnd())
+        return;
+
+    if (it->scanning > 0 || QDateTime::currentMSecsSinceEpoch() < it->ignoreChangesUntil)
+        return;
+
+    invalidate(topLevel);
+    emit checkoutChanged(topLevel);
+}
+
+void StatusTracker::clearScanned(Checkout &checkout, const QString &file, quint64 scanGeneration)
+{
+    // Keep the file dirty if it was marked again after the scan began
+    auto it = checkout.dirty.find(file);
+    if (it != checkout.dirty.end() && it.value() <= scanGeneration)
+        checkout.dirty.erase(it);
+}
+
+QString StatusTracker::topLevelOf(const QString &file) const
+{
+    // Only the checkouts with a baseline or being scanned are of interest, the
+    // rest will be fully scanned anyway. Prefer the innermost one for nested checkouts.
+    const QString path = QDir::fromNativeSeparators(file);
+    QString topLevel;
+    for (auto it = m_checkouts.constBegin(); it != m_checkouts.constEnd(); ++it) {
+        if (it.key().size() > topLevel.size()
+            && path.startsWith(it.key() + '/')) {
+            topLevel = it.key();
+        }
+    }
+    return topLevel;
+}
+
+QString StatusTracker::itemPath(const StatusItem &item)
+{
+    // Renamed entries come as "oldname => newname", track the new name.
+    const int pos = item.file.indexOf(" => ");
+    return (pos != -1 ? item.file.mid(pos + 4) : item.file);
+}
+
+} // namespace Internal
+} // namespace Fossil
@@ -0,0 +1,115 @@
+/**************************************************************************
+**  This file is part of Fossil VCS plugin for Qt Creator
+**
+**  Copyright (c) 2013 - 2017, Artur Shepilko, <qtc-fossil@nomadbyte.com>.
+**
+**  Based on Bazaar VCS plugin for Qt Creator by Hugues Delorme.
+**
+**  Permission is hereby granted, free of charge, to any person obtaining a copy
+**  of this software and associated documentation files (the "Software"), to deal
+**  in the Software without restriction, including without limitation the rights
+**  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+**  copies of the Software, and to permit persons to whom the Software is
+**  furnished to do so, subject to the following conditions:
+**
+**  The above copyright notice and this permission notice shall be included in
+**  all copies or substantial portions of the Software.
+**
+**  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+**  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+**  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+**  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+**  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+**  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+**  THE SOFTWARE.
+**************************************************************************/
+
+#pragma once
+
+#include <vcsbase/vcsbaseclient.h>
+
+#include <QHash>
+#include <QMap>
+#include <QObject>
+
+namespace Utils { class FileSystemWatcher; }
+
+namespace Fossil {
+namespace Internal {
+
+// Keeps the last known status of each checkout along with the set of files
+// that may have changed since. Files are marked dirty from editor saves and
+// internal file change notifications, so that only those need re-checking.
+// Files changed outside of Qt Creator are found by comparing the stamps
+// (modification time and size) of the checkout's files with the ones taken
+// for the previous scan; watching the directories would miss the files that
+// are written in place.
+// A checkout without a baseline (or an invalidated one) needs a full scan.
+// Each scan is tagged with a generation: a file marked dirty again while it
+// is being scanned stays dirty once the scan is done.
+class StatusTracker : public QObject
+{
+    Q_OBJECT
+
+public:
+    typedef VcsBase::VcsBaseClient::StatusItem StatusItem;
+
+    struct FileStamp
+    {
+        qint64 modified = 0; // msecs since epoch
+        qint64 size = -1;
+    };
+    typedef QHash<QString, FileStamp> FileStamps; // keyed by path relative to top-level
+
+    explicit StatusTracker(QObject *parent = nullptr);
+
+    bool hasBaseline(const QString &topLevel) const;
+    QStringList dirtyFiles(const QString &topLevel) const;
+    QList<StatusItem> status(const QString &topLevel) const;
+
+    void setBaseline(const QString &topLevel, const QList<StatusItem> &status,
+                     quint64 scanGeneration, const FileStamps &stamps);
+    void updateBaseline(const QString &topLevel, const QStringList &checkedFiles,
+                        const QList<StatusItem> &status, quint64 scanGeneration);
+
+    // Returns the generation of the scan, to be passed to set/updateBaseline().
+    quint64 beginScan(const QString &topLevel);
+    void endScan(const QString &topLevel);
+
+    // Takes the stamps of the files of a checkout, from any thread.
+    static FileStamps stampFiles(const QString &topLevel);
+    // Marks the files whose stamps changed since the baseline dirty,
+    // and keeps the new stamps.
+    void markChangedFiles(const QString &topLevel, const FileStamps &stamps);
+
+    void markFileDirty(const QString &file);
+    void markFilesDirty(const QStringList &files);
+    void invalidate(const QString &repository);
+
+signals:
+    // The checkout was changed outside of the tracked files.
+    void checkoutChanged(const QString &topLevel);
+
+private:
+    struct Checkout
+    {
+        QMap<QString, StatusItem> items; // keyed by path relative to top-level
+        QHash<QString, quint64> dirty;   // the generation the file was marked dirty in
+        FileStamps stamps;
+        quint64 generation = 0;
+        bool baseline = false;
+        int scanning = 0;
+        qint64 ignoreChangesUntil = 0;
+    };
+
+    void checkoutFileChanged(const QString &checkoutFile);
+    static void clearScanned(Checkout &checkout, const QString &file, quint64 scanGeneration);
+    QString topLevelOf(const QString &file) const;
+    static QString itemPath(const StatusItem &item);
+
+    QHash<QString, Checkout> m_checkouts;
+    Utils::FileSystemWatcher *m_watcher;
+};
+
+} // namespace Internal
+} // namespace Fossil
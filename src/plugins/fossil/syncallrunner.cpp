@@ -0,0 +1,178 @@
+/**************************************************************************
+**  This file is part of Fossil VCS plugin for Qt Creator
+**
+**  Copyright (c) 2013 - 2017, Artur Shepilko, <qtc-fossil@nomadbyte.com>.
+**
+**  Based on Bazaar VCS plugin for Qt Creator by Hugues Delorme.
+**
+**  Permission is hereby granted, free of charge, to any person obtaining a copy
+**  of this software and associated documentation files (the "Software"), to deal
+**  in the Software without restriction, including without limitation the rights
+**  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+**  copies of the Software, and to permit persons to whom the Software is
+**  furnished to do so, subject to the following conditions:
+**
+**  The above copyright notice and this permission notice shall be included in
+**  all copies or substantial portions of the Software.
+**
+**  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+**  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+**  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+**  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+**  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+**  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+**  THE SOFTWARE.
+**************************************************************************/
+
+#include "syncallrunner.h"
+#include "commandstatistics.h"
+#include "fossilclient.h"
+#include "jobscheduler.h"
+#include "statustracker.h"
+
+#include <vcsbase/vcscommand.h>
+#include <vcsbase/vcsoutputwindow.h>
+
+#include <utils/qtcassert.h>
+
+#include <QDir>
+#include <QSharedPointer>
+
+namespace Fossil {
+namespace Internal {
+
+SyncAllRunner::SyncAllRunner(FossilClient *client, const QStringList &repositories, int maxConcurrency,
+                             bool update, QObject *parent) :
+    QObject(parent),
+    m_client(client),
+    m_pending(repositories),
+    m_maxConcurrency(qMax(1, maxConcurrency)),
+    m_update(update)
+{
+    QTC_CHECK(m_client);
+}
+
+void SyncAllRunner::start()
+{
+    m_timer.start();
+    VcsBase::VcsOutputWindow::appendMessage(
+                tr("Syncing %n repositories, %1 at a time.", 0, m_pending.size())
+                .arg(qMin(m_maxConcurrency, m_pending.size())));
+
+    if (m_pending.isEmpty()) {
+        reportResults();
+        emit finished();
+        return;
+    }
+    startNext();
+}
+
+void SyncAllRunner::startNext()
+{
+    while (m_running < m_maxConcurrency && !m_pending.isEmpty()) {
+        const int index = m_results.size();
+        Result result;
+        result.repository = m_pending.takeFirst();
+        m_results.append(result);
+        ++m_running;
+
+        QSharedPointer<SyncProgress> progress(new SyncProgress);
+        QSharedPointer<QElapsedTimer> timer(new QElapsedTimer);
+        timer->start();
+
+        // Jobs run in sequence and stop at the first failure,
+        // so the checkout is only updated after a successful sync.
+        VcsBase::VcsCommand *command = m_client->createSyncCommand(result.repository, progress);
+        // Disable UNIX terminals to suppress SSH prompting
+        command->addFlags(VcsBase::VcsCommand::SshPasswordPrompt);
+        command->addJob(m_client->vcsBinary(), m_client->syncArguments(result.repository, "sync"),
+                        m_client->vcsTimeoutS());
+        if (m_update)
+            command->addJob(m_client->vcsBinary(), {"update"}, m_client->vcsTimeoutS());
+        m_client->commandStatistics()->instrument(command, "sync", result.repository);
+        connect(command, &VcsBase::VcsCommand::finished, this,
+                [this, index, progress, timer](bool ok) {
+            repositoryFinished(index, ok, timer->elapsed(), progress->statistics());
+        });
+        m_client->jobScheduler()->schedule(result.repository, JobScheduler::Background, command,
+                                           [command]() { command->execute(); });
+    }
+}
+
+void SyncAllRunner::repositoryFinished(int index, bool ok, qint64 elapsedMs,
+                                       const SyncStatistics &statistics)
+{
+    QTC_ASSERT(index >= 0 && index < m_results.size(), return);
+
+    Result &result = m_results[index];
+    result.ok = ok;
+    result.elapsedMs = elapsedMs;
+    result.statistics = statistics;
+    --m_running;
+
+    // A failed sync leaves the repository and its checkout as they were.
+    if (ok) {
+        m_client->statusTracker()->invalidate(result.repository);
+        emit m_client->changed(QVariant(result.repository));
+    }
+
+    if (m_running == 0 && m_pending.isEmpty()) {
+        reportResults();
+        emit finished();
+        return;
+    }
+    startNext();
+}
+
+void SyncAllRunner::reportResults() const
+{
+    const QStringList header({tr("Repository"), tr("Result"), tr("Round-trips"),
+                              tr("Sent"), tr("Received"), tr("Time")});
+
+    QList<QStringList> rows;
+    rows.append(header);
+    qint64 slowestMs = 0;
+    int failed = 0;
+    for (const Result &result : m_results) {
+        slowestMs = qMax(slowestMs, result.elapsedMs);
+        if (!result.ok)
+            ++failed;
+        rows.append({QDir::toNativeSeparators(result.repository),
+                     result.ok ? tr("OK") : tr("Failed"),
+                     QString::number(result.statistics.roundTrips),
+                     tr("%1 (%2 B)").arg(result.statistics.artifactsSent)
+                                    .arg(result.statistics.bytesSent),
+                     tr("%1 (%2 B)").arg(result.statistics.artifactsReceived)
+                                    .arg(result.statistics.bytesReceived),
+                     QString::number(result.elapsedMs / 1000.0, 'f', 1) + " s"});
+    }
+
+    QVector<int> widths(header.size(), 0);
+    for (const QStringList &row : rows) {
+        for (int column = 0; column < row.size(); ++column)
+            widths[column] = qMax(widths.at(column), row.at(column).size());
+    }
+
+    QString table;
+    for (const QStringList &row : rows) {
+        QStringList cells;
+        for (int column = 0; column < row.size(); ++column) {
+            // Left-align the text columns, right-align the numbers.
+            cells << (column < 2 ? row.at(column).leftJustified(widths.at(column))
+                                 : row.at(column).rightJustified(widths.at(column)));
+        }
+        table += cells.join("  ") + '\n';
+    }
+    table += tr("%n repositories synced in %1 s (slowest %2 s), %3 failed.", 0, m_results.size())
+            .arg(m_timer.elapsed() / 1000.0, 0, 'f', 1)
+            .arg(slowestMs / 1000.0, 0, 'f', 1)
+            .arg(failed);
+
+    if (failed)
+        VcsBase::VcsOutputWindow::appendError(table);
+    else
+        VcsBase::VcsOutputWindow::appendMessage(table);
+}
+
+} // namespace Internal
+} // namespace Fossil
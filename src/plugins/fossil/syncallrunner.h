@@ -0,0 +1,80 @@
+/**************************************************************************
+**  This file is part of Fossil VCS plugin for Qt Creator
+**
+**  Copyright (c) 2013 - 2017, Artur Shepilko, <qtc-fossil@nomadbyte.com>.
+**
+**  Based on Bazaar VCS plugin for Qt Creator by Hugues Delorme.
+**
+**  Permission is hereby granted, free of charge, to any person obtaining a copy
+**  of this software and associated documentation files (the "Software"), to deal
+**  in the Software without restriction, including without limitation the rights
+**  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+**  copies of the Software, and to permit persons to whom the Software is
+**  furnished to do so, subject to the following conditions:
+**
+**  The above copyright notice and this permission notice shall be included in
+**  all copies or substantial portions of the Software.
+**
+**  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+**  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+**  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+**  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+**  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+**  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+**  THE SOFTWARE.
+**************************************************************************/
+
+#pragma once
+
+#include "syncprogressparser.h"
+
+#include <QElapsedTimer>
+#include <QObject>
+#include <QStringList>
+#include <QVector>
+
+namespace Fossil {
+namespace Internal {
+
+class FossilClient;
+
+// Syncs (pull and push, then update if asked to) a set of checkouts,
+// running at most maxConcurrency of them at a time, and reports the results
+// as a table to the version control output pane once all of them are done.
+class SyncAllRunner : public QObject
+{
+    Q_OBJECT
+
+public:
+    SyncAllRunner(FossilClient *client, const QStringList &repositories, int maxConcurrency,
+                  bool update, QObject *parent = nullptr);
+
+    void start();
+
+signals:
+    void finished();
+
+private:
+    struct Result
+    {
+        QString repository;
+        bool ok = false;
+        qint64 elapsedMs = 0;
+        SyncStatistics statistics;
+    };
+
+    void startNext();
+    void repositoryFinished(int index, bool ok, qint64 elapsedMs, const SyncStatistics &statistics);
+    void reportResults() const;
+
+    FossilClient *const m_client;
+    QStringList m_pending;
+    QVector<Result> m_results;
+    const int m_maxConcurrency;
+    const bool m_update;
+    int m_running = 0;
+    QElapsedTimer m_timer;
+};
+
+} // namespace Internal
+} // namespace Fossil
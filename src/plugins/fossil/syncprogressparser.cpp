@@ -0,0 +1,89 @@
+/**************************************************************************
+**  This file is part of Fossil VCS plugin for Qt Creator
+**
+**  Copyright (c) 2013 - 2017, Artur Shepilko, <qtc-fossil@nomadbyte.com>.
+**
+**  Based on Bazaar VCS plugin for Qt Creator by Hugues Delorme.
+**
+**  Permission is hereby granted, free of charge, to any person obtaining a copy
+**  of this software and associated documentation files (the "Software"), to deal
+**  in the Software without restriction, including without limitation the rights
+**  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+**  copies of the Software, and to permit persons to whom the Software is
+**  furnished to do so, subject to the following conditions:
+**
+**  The above copyright notice and this permission notice shall be included in
+**  all copies or substantial portions of the Software.
+**
+**  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+**  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+**  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+**  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+**  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+**  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+**  THE SOFTWARE.
+**************************************************************************/
+
+#include "syncprogressparser.h"
+
+#include <utils/qtcassert.h>
+
+namespace Fossil {
+namespace Internal {
+
+SyncStatistics SyncProgress::statistics() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_statistics;
+}
+
+void SyncProgress::setStatistics(const SyncStatistics &statistics)
+{
+    QMutexLocker locker(&m_mutex);
+    m_statistics = statistics;
+}
+
+SyncProgressParser::SyncProgressParser(const QSharedPointer<SyncProgress> &progress) :
+    m_progress(progress),
+    m_roundTripRx("Round-trips:\\s*(\\d+)\\s+Artifacts sent:\\s*(\\d+)\\s+received:\\s*(\\d+)"),
+    m_doneRx("done,\\s*(?:wire bytes )?sent:\\s*(\\d+)\\s+received:\\s*(\\d+)")
+{
+    QTC_CHECK(m_progress);
+    QTC_CHECK(m_roundTripRx.isValid());
+    QTC_CHECK(m_doneRx.isValid());
+}
+
+void SyncProgressParser::parseProgress(const QString &text)
+{
+    // Fossil keeps re-printing the round-trip counters on the same line ('\r'),
+    // only the most recent ones are of interest.
+    bool updated = false;
+
+    QRegularExpressionMatchIterator i = m_roundTripRx.globalMatch(text);
+    while (i.hasNext()) {
+        const QRegularExpressionMatch roundTripMatch = i.next();
+        m_statistics.roundTrips = roundTripMatch.captured(1).toInt();
+        m_statistics.artifactsSent = roundTripMatch.captured(2).toInt();
+        m_statistics.artifactsReceived = roundTripMatch.captured(3).toInt();
+        updated = true;
+    }
+
+    const QRegularExpressionMatch doneMatch = m_doneRx.match(text);
+    if (doneMatch.hasMatch()) {
+        m_statistics.bytesSent = doneMatch.captured(1).toLongLong();
+        m_statistics.bytesReceived = doneMatch.captured(2).toLongLong();
+        updated = true;
+    }
+
+    if (!updated)
+        return;
+
+    // The total number of round-trips is not known in advance,
+    // so keep the progress one step ahead of the current one.
+    setProgressAndMaximum(m_statistics.roundTrips, m_statistics.roundTrips + 1);
+    if (m_progress)
+        m_progress->setStatistics(m_statistics);
+}
+
+} // namespace Internal
+} // namespace Fossil
@@ -0,0 +1,82 @@
+/**************************************************************************
+**  This file is part of Fossil VCS plugin for Qt Creator
+**
+**  Copyright (c) 2013 - 2017, Artur Shepilko, <qtc-fossil@nomadbyte.com>.
+**
+**  Based on Bazaar VCS plugin for Qt Creator by Hugues Delorme.
+**
+**  Permission is hereby granted, free of charge, to any person obtaining a copy
+**  of this software and associated documentation files (the "Software"), to deal
+**  in the Software without restriction, including without limitation the rights
+**  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+**  copies of the Software, and to permit persons to whom the Software is
+**  furnished to do so, subject to the following conditions:
+**
+**  The above copyright notice and this permission notice shall be included in
+**  all copies or substantial portions of the Software.
+**
+**  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+**  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+**  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+**  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+**  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+**  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+**  THE SOFTWARE.
+**************************************************************************/
+
+#pragma once
+
+#include <utils/shellcommand.h>
+
+#include <QMutex>
+#include <QRegularExpression>
+#include <QSharedPointer>
+
+namespace Fossil {
+namespace Internal {
+
+struct SyncStatistics
+{
+    int roundTrips = 0;
+    int artifactsSent = 0;
+    int artifactsReceived = 0;
+    qint64 bytesSent = 0;
+    qint64 bytesReceived = 0;
+};
+
+// Transfer statistics shared between the progress parser running
+// in the command's thread and the command's issuer.
+class SyncProgress
+{
+public:
+    SyncStatistics statistics() const;
+    void setStatistics(const SyncStatistics &statistics);
+
+private:
+    mutable QMutex m_mutex;
+    SyncStatistics m_statistics;
+
+    friend class FossilPlugin;
+};
+
+// Parses the transfer counters reported by fossil clone/pull/push/sync:
+//   "Round-trips: 2   Artifacts sent: 0  received: 12"
+//   "Pull done, sent: 1234  received: 56789  ip: 10.0.0.1"
+//   "Pull done, wire bytes sent: 1234  received: 56789  ip: 10.0.0.1" (newer versions)
+class SyncProgressParser : public Utils::ProgressParser
+{
+public:
+    explicit SyncProgressParser(const QSharedPointer<SyncProgress> &progress);
+
+protected:
+    void parseProgress(const QString &text) final;
+
+private:
+    const QSharedPointer<SyncProgress> m_progress;
+    const QRegularExpression m_roundTripRx;
+    const QRegularExpression m_doneRx;
+    SyncStatistics m_statistics;
+};
+
+} // namespace Internal
+} // namespace Fossil
@@ -0,0 +1,417 @@
+/**************************************************************************
+**  This file is part of Fossil VCS plugin for Qt Creator
+**
+**  Copyright (c) 2013 - 2017, Artur Shepilko, <qtc-fossil@nomadbyte.com>.
+**
+**  Based on Bazaar VCS plugin for Qt Creator by Hugues Delorme.
+**
+**  Permission is hereby granted, free of charge, to any person obtaining a copy
+**  of this software and associated documentation files (the "Software"), to deal
+**  in the Software without restriction, including without limitation the rights
+**  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+**  copies of the Software, and to permit persons to whom the Software is
+**  furnished to do so, subject to the following conditions:
+**
+**  The above copyright notice and this permission notice shall be included in
+**  all copies or substantial portions of the Software.
+**
+**  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+**  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+**  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+**  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+**  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+**  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+**  THE SOFTWARE.
+**************************************************************************/
+
+#include "syncproxy.h"
+
+#include <utils/qtcassert.h>
+
+#include <QBuffer>
+#include <QHash>
+#include <QLoggingCategory>
+#include <QNetworkAccessManager>
+#include <QNetworkProxy>
+#include <QNetworkReply>
+#include <QNetworkRequest>
+#include <QPointer>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTimer>
+#include <QUrl>
+#include <QUuid>
+
+namespace Fossil {
+namespace Internal {
+
+static Q_LOGGING_CATEGORY(syncProxyLog, "qtc.fossil.syncproxy")
+
+namespace {
+
+struct Request
+{
+    QByteArray method;
+    QByteArray target;
+    QList<QPair<QByteArray, QByteArray>> headers;
+    QByteArray body;
+    int contentLength = 0;
+    bool keepAlive = true;
+};
+
+// Hop-by-hop headers, and the ones set by the relay itself
+bool isRelayedHeader(const QByteArray &name)
+{
+    static const QList<QByteArray> local = {
+        "host", "connection", "keep-alive", "proxy-connection", "te", "upgrade",
+        "content-length", "transfer-encoding", "content-encoding", "accept-encoding"
+    };
+    return !local.contains(name.toLower());
+}
+
+bool parseHead(const QByteArray &head, Request *request)
+{
+    const QList<QByteArray> lines = head.split('\n');
+    const QList<QByteArray> requestLine = lines.first().trimmed().split(' ');
+    if (requestLine.size() != 3)
+        return false;
+
+    request->method = requestLine.at(0);
+    request->target = requestLine.at(1);
+    const bool http10 = requestLine.at(2) == "HTTP/1.0";
+    request->keepAlive = !http10;
+
+    for (int i = 1; i < lines.size(); ++i) {
+        const QByteArray &line = lines.at(i);
+        const int colon = line.indexOf(':');
+        if (colon <= 0)
+            continue;
+        const QByteArray name = line.left(colon).trimmed();
+        const QByteArray value = line.mid(colon + 1).trimmed();
+        const QByteArray lowerName = name.toLower();
+        if (lowerName == "content-length")
+            request->contentLength = value.toInt();
+        else if (lowerName == "connection")
+            request->keepAlive = value.toLower() == "keep-alive" || (!http10 && value.toLower() != "close");
+        if (isRelayedHeader(name))
+            request->headers.append(qMakePair(name, value));
+    }
+    return request->contentLength >= 0;
+}
+
+// "/<token>/repo/xfer" is relayed as "/repo/xfer"
+bool stripToken(const QByteArray &token, QByteArray *target)
+{
+    const QByteArray prefix = '/' + token;
+    if (!target->startsWith(prefix))
+        return false;
+    const QByteArray rest = target->mid(prefix.size());
+    if (rest.isEmpty() || rest.startsWith('?')) {
+        *target = '/' + rest;
+        return true;
+    }
+    if (!rest.startsWith('/'))
+        return false;
+    *target = rest;
+    return true;
+}
+
+} // namespace
+
+class SyncProxyWorker : public QObject
+{
+    Q_OBJECT
+
+public:
+    SyncProxyWorker(const QByteArray &token, int timeoutMs) :
+        timeoutMs(timeoutMs), m_token(token)
+    { }
+
+    // Returns the local port relaying to origin, 0 if there is none.
+    Q_INVOKABLE int listen(const QUrl &origin);
+
+    QAtomicInt connections;
+    QAtomicInt requests;
+    QAtomicInt timeoutMs;
+
+private:
+    struct Connection
+    {
+        QUrl origin;
+        QByteArray buffer;
+        QTimer *idleTimer = nullptr;
+        bool busy = false;
+    };
+
+    void accept(QTcpServer *server, const QUrl &origin);
+    void read(QTcpSocket *socket);
+    void forward(QTcpSocket *socket, const QUrl &origin, const Request &request);
+    void respond(QTcpSocket *socket, QNetworkReply *reply, bool keepAlive);
+    QNetworkAccessManager *network();
+
+    QTimer *newTimeoutTimer(QObject *parent);
+
+    const QByteArray m_token;
+    QHash<QString, QTcpServer *> m_servers;
+    QHash<QTcpSocket *, Connection> m_connections;
+    QNetworkAccessManager *m_network = nullptr;
+};
+
+int SyncProxyWorker::listen(const QUrl &origin)
+{
+    const QString key = origin.toString();
+    if (QTcpServer *server = m_servers.value(key))
+        return server->serverPort();
+
+    auto server = new QTcpServer(this);
+    if (!server->listen(QHostAddress::LocalHost)) {
+        qCWarning(syncProxyLog, "Cannot relay to %s: %s",
+                  qPrintable(key), qPrintable(server->errorString()));
+        delete server;
+        return 0;
+    }
+    connect(server, &QTcpServer::newConnection, this, [this, server, origin]() {
+        accept(server, origin);
+    });
+    m_servers.insert(key, server);
+    return server->serverPort();
+}
+
+void SyncProxyWorker::accept(QTcpServer *server, const QUrl &origin)
+{
+    while (QTcpSocket *socket = server->nextPendingConnection()) {
+        connections.ref();
+        Connection &connection = m_connections[socket];
+        connection.origin = origin;
+        connection.idleTimer = newTimeoutTimer(socket);
+        connect(connection.idleTimer, &QTimer::timeout, socket, &QAbstractSocket::disconnectFromHost);
+        connect(socket, &QTcpSocket::readyRead, this, [this, socket]() { read(socket); });
+        connect(socket, &QTcpSocket::disconnected, this, [this, socket]() {
+            m_connections.remove(socket);
+            socket->deleteLater();
+        });
+    }
+}
+
+void SyncProxyWorker::read(QTcpSocket *socket)
+{
+    auto it = m_connections.find(socket);
+    if (it == m_connections.end())
+        return;
+
+    it->buffer += socket->readAll();
+    // fossil waits for the reply before sending its next request
+    if (it->busy)
+        return;
+    it->idleTimer->start();
+
+    const int headEnd = it->buffer.indexOf("\r\n\r\n");
+    if (headEnd < 0)
+        return;
+
+    Request request;
+    if (!parseHead(it->buffer.left(headEnd), &request)) {
+        socket->write("HTTP/1.1 400 Bad Request\r\nContent-Length: 0\r\nConnection: close\r\n\r\n");
+        socket->disconnectFromHost();
+        return;
+    }
+    if (!stripToken(m_token, &request.target)) {
+        qCWarning(syncProxyLog, "Refused a request without the session token");
+        socket->write("HTTP/1.1 403 Forbidden\r\nContent-Length: 0\r\nConnection: close\r\n\r\n");
+        socket->disconnectFromHost();
+        return;
+    }
+    const int size = headEnd + 4 + request.contentLength;
+    if (it->buffer.size() < size)
+        return;
+
+    request.body = it->buffer.mid(headEnd + 4, request.contentLength);
+    it->buffer.remove(0, size);
+    it->busy = true;
+    it->idleTimer->stop();
+    forward(socket, it->origin, request);
+}
+
+void SyncProxyWorker::forward(QTcpSocket *socket, const QUrl &origin, const Request &request)
+{
+    requests.ref();
+
+    QNetworkRequest networkRequest(origin.resolved(QUrl::fromEncoded(request.target)));
+    // The cookies belong to the fossil process, the connections are shared
+    networkRequest.setAttribute(QNetworkRequest::CookieLoadControlAttribute, QNetworkRequest::Manual);
+    networkRequest.setAttribute(QNetworkRequest::CookieSaveControlAttribute, QNetworkRequest::Manual);
+    for (const QPair<QByteArray, QByteArray> &header : request.headers)
+        networkRequest.setRawHeader(header.first, header.second);
+
+    QBuffer *body = nullptr;
+    if (!request.body.isEmpty()) {
+        body = new QBuffer;
+        body->setData(request.body);
+        body->open(QIODevice::ReadOnly);
+    }
+    QNetworkReply *reply = network()->sendCustomRequest(networkRequest, request.method, body);
+    if (body)
+        body->setParent(reply);
+
+    // Given up on when the remote stalls, with the timer restarted on any progress
+    QTimer *stallTimer = newTimeoutTimer(reply);
+    connect(stallTimer, &QTimer::timeout, reply, &QNetworkReply::abort);
+    connect(reply, &QNetworkReply::uploadProgress, stallTimer, [stallTimer]() { stallTimer->start(); });
+    connect(reply, &QNetworkReply::downloadProgress, stallTimer, [stallTimer]() { stallTimer->start(); });
+
+    const QPointer<QTcpSocket> client(socket);
+    const bool keepAlive = request.keepAlive;
+    connect(reply, &QNetworkReply::finished, this, [this, client, reply, keepAlive]() {
+        reply->deleteLater();
+        if (client)
+            respond(client, reply, keepAlive);
+    });
+}
+
+void SyncProxyWorker::respond(QTcpSocket *socket, QNetworkReply *reply, bool keepAlive)
+{
+    int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    QByteArray reason = reply->attribute(QNetworkRequest::HttpReasonPhraseAttribute).toByteArray();
+    QByteArray body = reply->readAll();
+    QList<QNetworkReply::RawHeaderPair> headers;
+    if (status == 0) {
+        qCWarning(syncProxyLog, "Relaying to %s failed: %s",
+                  qPrintable(reply->url().toString()), qPrintable(reply->errorString()));
+        const bool stalled = reply->error() == QNetworkReply::OperationCanceledError;
+        status = stalled ? 504 : 502;
+        reason = stalled ? "Gateway Timeout" : "Bad Gateway";
+        body = reply->errorString().toUtf8();
+        headers.append(qMakePair(QByteArray("Content-Type"), QByteArray("text/plain")));
+    } else {
+        for (const QNetworkReply::RawHeaderPair &header : reply->rawHeaderPairs()) {
+            if (isRelayedHeader(header.first))
+                headers.append(header);
+        }
+    }
+
+    QByteArray response = "HTTP/1.1 " + QByteArray::number(status) + ' ' + reason + "\r\n";
+    for (const QNetworkReply::RawHeaderPair &header : headers) {
+        // Repeated headers, e.g. Set-Cookie, are joined by newlines
+        for (const QByteArray &value : header.second.split('\n'))
+            response += header.first + ": " + value + "\r\n";
+    }
+    response += "Content-Length: " + QByteArray::number(body.size()) + "\r\n";
+    response += keepAlive ? "Connection: keep-alive\r\n" : "Connection: close\r\n";
+    response += "\r\n";
+    response += body;
+    socket->write(response);
+
+    if (!keepAlive) {
+        socket->disconnectFromHost();
+        return;
+    }
+
+    auto it = m_connections.find(socket);
+    QTC_ASSERT(it != m_connections.end(), return);
+    it->busy = false;
+    it->idleTimer->start();
+    if (!it->buffer.isEmpty())
+        read(socket);
+}
+
+QTimer *SyncProxyWorker::newTimeoutTimer(QObject *parent)
+{
+    auto timer = new QTimer(parent);
+    timer->setSingleShot(true);
+    timer->setInterval(timeoutMs.load());
+    timer->start();
+    return timer;
+}
+
+QNetworkAccessManager *SyncProxyWorker::network()
+{
+    // Created in the relay thread, where its connections are kept alive.
+    // Only remotes that fossil itself reaches without a proxy are relayed.
+    if (!m_network) {
+        m_network = new QNetworkAccessManager(this);
+        m_network->setProxy(QNetworkProxy::NoProxy);
+    }
+    return m_network;
+}
+
+SyncProxy::SyncProxy(QObject *parent) :
+    QObject(parent),
+    m_token(QUuid::createUuid().toRfc4122().toHex())
+{
+    m_thread.setObjectName("FossilSyncProxy");
+}
+
+SyncProxy::~SyncProxy()
+{
+    m_thread.quit();
+    m_thread.wait();
+}
+
+QString SyncProxy::localUrl(const QString &remote)
+{
+    QTC_ASSERT(QThread::currentThread() != &m_thread, return remote);
+
+    const QUrl url(remote);
+    if (!canRelay(url))
+        return remote;
+
+    QUrl origin;
+    origin.setScheme(url.scheme().toLower());
+    origin.setHost(url.host());
+    origin.setPort(url.port());
+
+    int port = 0;
+    QMetaObject::invokeMethod(worker(), "listen", Qt::BlockingQueuedConnection,
+                              Q_RETURN_ARG(int, port), Q_ARG(QUrl, origin));
+    if (port == 0)
+        return remote;
+
+    QUrl local(url);
+    local.setScheme("http");
+    local.setHost("127.0.0.1");
+    local.setPort(port);
+    local.setPath('/' + QString::fromLatin1(m_token) + url.path());
+    return local.toString();
+}
+
+int SyncProxy::connectionCount() const
+{
+    return m_worker ? m_worker->connections.load() : 0;
+}
+
+int SyncProxy::requestCount() const
+{
+    return m_worker ? m_worker->requests.load() : 0;
+}
+
+void SyncProxy::setTimeout(int timeoutMs)
+{
+    // Applies to the connections and requests to come
+    m_timeoutMs = timeoutMs;
+    if (m_worker)
+        m_worker->timeoutMs.store(timeoutMs);
+}
+
+SyncProxyWorker *SyncProxy::worker()
+{
+    if (!m_worker) {
+        m_worker = new SyncProxyWorker(m_token, m_timeoutMs);
+        m_worker->moveToThread(&m_thread);
+        connect(&m_thread, &QThread::finished, m_worker, &QObject::deleteLater);
+        m_thread.start();
+    }
+    return m_worker;
+}
+
+bool SyncProxy::canRelay(const QUrl &remote)
+{
+    const QString scheme = remote.scheme().toLower();
+    if (scheme != "http" && scheme != "https")
+        return false;
+    return remote.userName().isEmpty() || !remote.password().isEmpty();
+}
+
+} // namespace Internal
+} // namespace Fossil
+
+#include "syncproxy.moc"
@@ -0,0 +1,86 @@
+/**************************************************************************
+**  This file is part of Fossil VCS plugin for Qt Creator
+**
+**  Copyright (c) 2013 - 2017, Artur Shepilko, <qtc-fossil@nomadbyte.com>.
+**
+**  Based on Bazaar VCS plugin for Qt Creator by Hugues Delorme.
+**
+**  Permission is hereby granted, free of charge, to any person obtaining a copy
+**  of this software and associated documentation files (the "Software"), to deal
+**  in the Software without restriction, including without limitation the rights
+**  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+**  copies of the Software, and to permit persons to whom the Software is
+**  furnished to do so, subject to the following conditions:
+**
+**  The above copyright notice and this permission notice shall be included in
+**  all copies or substantial portions of the Software.
+**
+**  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+**  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+**  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+**  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+**  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+**  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+**  THE SOFTWARE.
+**************************************************************************/
+
+#pragma once
+
+#include <QObject>
+#include <QThread>
+
+QT_BEGIN_NAMESPACE
+class QUrl;
+QT_END_NAMESPACE
+
+namespace Fossil {
+namespace Internal {
+
+class SyncProxyWorker;
+
+// Relays the HTTP(S) sync requests of fossil processes to their remote
+// repositories over connections kept open between the processes, so that
+// repeated pulls and pushes do not each pay for a new TCP and TLS handshake.
+// Each remote gets a listener on localhost; fossil is then pointed to
+// localUrl() instead of the remote. The relay runs in a thread of its own,
+// it keeps serving while the GUI thread waits on a synchronous pull. The thread
+// is only started for the first remote relayed.
+// The relay connects directly, without client certificate, and trusts the
+// system's certificate authorities only.
+// Only the requests whose path starts with the random token of the session
+// are relayed, so that other local users cannot reach the remotes through it.
+// Connections idle and replies stalled for longer than the timeout are closed.
+class SyncProxy : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit SyncProxy(QObject *parent = nullptr);
+    ~SyncProxy() override;
+
+    // Returns the URL relaying to remote, or remote itself if it cannot be relayed.
+    QString localUrl(const QString &remote);
+
+    int connectionCount() const;
+    int requestCount() const;
+
+    void setTimeout(int timeoutMs);
+    static const int defaultTimeoutMs = 60000;
+
+    // SSH and file remotes are not HTTP. A remote with a user but no password
+    // relies on the password fossil stored for that very URL.
+    static bool canRelay(const QUrl &remote);
+
+private:
+    SyncProxyWorker *worker();
+
+    const QByteArray m_token;
+    int m_timeoutMs = defaultTimeoutMs;
+    QThread m_thread;
+    SyncProxyWorker *m_worker = nullptr;
+
+    friend class FossilPlugin;
+};
+
+} // namespace Internal
+} // namespace Fossil
@@ -0,0 +1,140 @@
+/**************************************************************************
+**  This file is part of Fossil VCS plugin for Qt Creator
+**
+**  Copyright (c) 2013 - 2017, Artur Shepilko, <qtc-fossil@nomadbyte.com>.
+**
+**  Based on Bazaar VCS plugin for Qt Creator by Hugues Delorme.
+**
+**  Permission is hereby granted, free of charge, to any person obtaining a copy
+**  of this software and associated documentation files (the "Software"), to deal
+**  in the Software without restriction, including without limitation the rights
+**  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+**  copies of the Software, and to permit persons to whom the Software is
+**  furnished to do so, subject to the following conditions:
+**
+**  The above copyright notice and this permission notice shall be included in
+**  all copies or substantial portions of the Software.
+**
+**  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+**  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+**  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+**  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+**  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+**  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+**  THE SOFTWARE.
+**************************************************************************/
+
+#include "templatepool.h"
+#include "commandstatistics.h"
+#include "constants.h"
+#include "fossilclient.h"
+#include "fossilsettings.h"
+
+#include <vcsbase/vcscommand.h>
+
+#include <utils/qtcassert.h>
+
+#include <QDir>
+#include <QFile>
+#include <QRegularExpression>
+#include <QUuid>
+
+namespace Fossil {
+namespace Internal {
+
+static const char templatesDirName[] = ".fossil-templates";
+static const char partialSuffix[] = ".part";
+
+RepositoryTemplatePool::RepositoryTemplatePool(FossilClient *client) :
+    QObject(client),
+    m_client(client)
+{
+    QTC_CHECK(m_client);
+}
+
+QString RepositoryTemplatePool::directory() const
+{
+    const QString repoPath = m_client->settings().stringValue(FossilSettings::defaultRepoPathKey);
+    if (repoPath.isEmpty())
+        return QString();
+
+    // Templates are created for the configured admin user
+    QString adminUser = m_client->settings().stringValue(FossilSettings::userNameKey);
+    adminUser.replace(QRegularExpression("[^A-Za-z0-9_.@-]"), "_");
+    if (adminUser.isEmpty())
+        adminUser = "default";
+
+    return QDir(repoPath).absoluteFilePath(QString(templatesDirName) + '/' + adminUser);
+}
+
+QStringList RepositoryTemplatePool::templates() const
+{
+    const QString dir = directory();
+    if (dir.isEmpty())
+        return QStringList();
+
+    const QStringList nameFilters(QString("*") + Constants::FOSSIL_FILE_SUFFIX);
+    const QStringList names = QDir(dir).entryList(nameFilters, QDir::Files, QDir::Name);
+
+    QStringList templates;
+    for (const QString &name : names)
+        templates << dir + '/' + name;
+    return templates;
+}
+
+bool RepositoryTemplatePool::takeTemplate(const QString &repositoryFile)
+{
+    if (m_client->settings().intValue(FossilSettings::repositoryTemplatesKey) <= 0)
+        return false;
+
+    bool taken = false;
+    for (const QString &templateFile : templates()) {
+        if (QFile::rename(templateFile, repositoryFile)) {
+            taken = true;
+            break;
+        }
+    }
+
+    refill();
+    return taken;
+}
+
+void RepositoryTemplatePool::refill()
+{
+    const int poolSize = m_client->settings().intValue(FossilSettings::repositoryTemplatesKey);
+    if (poolSize <= 0 || m_generating)
+        return;
+
+    const QString dir = directory();
+    if (dir.isEmpty() || !QDir().mkpath(dir) || templates().size() >= poolSize)
+        return;
+
+    const QString name = QUuid::createUuid().toString().mid(1, 36);
+    const QString partialFile = dir + '/' + name + Constants::FOSSIL_FILE_SUFFIX + partialSuffix;
+    const QString adminUser = m_client->settings().stringValue(FossilSettings::userNameKey);
+
+    QStringList args("new");
+    if (!adminUser.isEmpty())
+        args << "--admin-user" << adminUser;
+    args << QDir::toNativeSeparators(partialFile);
+
+    m_generating = true;
+    VcsBase::VcsCommand *command = m_client->createCommand(dir);
+    command->addFlags(VcsBase::VcsCommand::NoOutput);
+    connect(command, &VcsBase::VcsCommand::finished, this, [this, partialFile](bool ok) {
+        m_generating = false;
+        const QString templateFile = partialFile.left(partialFile.size() - int(qstrlen(partialSuffix)));
+        if (!ok || !QFile::rename(partialFile, templateFile)) {
+            // Do not retry on errors, the next repository creation will.
+            QFile::remove(partialFile);
+            return;
+        }
+        refill();
+    });
+    command->addJob(m_client->vcsBinary(), args, -1);
+    m_client->commandStatistics()->instrument(command, "new", dir);
+    command->execute();
+}
+
+} // namespace Internal
+} // namespace Fossil
@@ -0,0 +1,62 @@
+/**************************************************************************
+**  This file is part of Fossil VCS plugin for Qt Creator
+**
+**  Copyright (c) 2013 - 2017, Artur Shepilko, <qtc-fossil@nomadbyte.com>.
+**
+**  Based on Bazaar VCS plugin for Qt Creator by Hugues Delorme.
+**
+**  Permission is hereby granted, free of charge, to any person obtaining a copy
+**  of this software and associated documentation files (the "Software"), to deal
+**  in the Software without restriction, including without limitation the rights
+**  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+**  copies of the Software, and to permit persons to whom the Software is
+**  furnished to do so, subject to the following conditions:
+**
+**  The above copyright notice and this permission notice shall be included in
+**  all copies or substantial portions of the Software.
+**
+**  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+**  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+**  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+**  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+**  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+**  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+**  THE SOFTWARE.
+**************************************************************************/
+
+#pragma once
+
+#include <QObject>
+#include <QStringList>
+
+namespace Fossil {
+namespace Internal {
+
+class FossilClient;
+
+// Keeps a number of freshly created, empty repository files in the default
+// repository location, so creating a repository does not have to wait for
+// "fossil new". Every template is a distinct repository (own project code),
+// hence templates are handed out once by renaming and never copied.
+class RepositoryTemplatePool : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit RepositoryTemplatePool(FossilClient *client);
+
+    // Moves a template to repositoryFile, returns false when none is available.
+    bool takeTemplate(const QString &repositoryFile);
+    // Creates the missing templates in the background, one at a time.
+    void refill();
+
+private:
+    QString directory() const;
+    QStringList templates() const;
+
+    FossilClient *const m_client;
+    bool m_generating = false;
+};
+
+} // namespace Internal
+} // namespace Fossil
@@ -0,0 +1,277 @@
+/**************************************************************************
+**  This file is part of Fossil VCS plugin for Qt Creator
+**
+**  Copyright (c) 2013 - 2017, Artur Shepilko, <qtc-fossil@nomadbyte.com>.
+**
+**  Based on Bazaar VCS plugin for Qt Creator by Hugues Delorme.
+**
+**  Permission is hereby granted, free of charge, to any person obtaining a copy
+**  of this software and associated documentation files (the "Software"), to deal
+**  in the Software without restriction, including without limitation the rights
+**  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+**  copies of the Software, and to permit persons to whom the Software is
+**  furnished to do so, subject to the following conditions:
+**
+**  The above copyright notice and this permission notice shall be included in
+**  all copies or substantial portions of the Software.
+**
+**  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+**  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+**  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+**  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+**  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+**  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+**  THE SOFTWARE.
+**************************************************************************/
+
+#include "toplevelcache.h"
+#include "constants.h"
+
+#include <utils/filesystemwatcher.h>
+#include <utils/hostosinfo.h>
+
+#include <QDir>
+#include <QFileInfo>
+#include <QThread>
+#include <QVector>
+
+namespace Fossil {
+namespace Internal {
+
+TopLevelCache::TopLevelCache(QObject *parent) :
+    QObject(parent),
+    m_watcher(new Utils::FileSystemWatcher(this))
+{
+    m_clock.start();
+    connect(m_watcher, &Utils::FileSystemWatcher::fileChanged,
+            this, &TopLevelCache::checkoutFileChanged);
+    connect(m_watcher, &Utils::FileSystemWatcher::directoryChanged,
+            this, &TopLevelCache::directoryChanged);
+    connect(this, &TopLevelCache::topLevelFound,
+            this, &TopLevelCache::watchTopLevel, Qt::QueuedConnection);
+    connect(this, &TopLevelCache::directoryQueried,
+            this, &TopLevelCache::listDirectory, Qt::QueuedConnection);
+    connect(this, &TopLevelCache::listingsDropped,
+            this, &TopLevelCache::unwatchDroppedDirectories, Qt::QueuedConnection);
+}
+
+static QString fileNameKey(const QString &fileName)
+{
+    return Utils::HostOsInfo::fileNameCaseSensitivity() == Qt::CaseSensitive ? fileName
+                                                                             : fileName.toLower();
+}
+
+QString TopLevelCache::topLevel(const QString &directory)
+{
+    // Same lookup as VcsBasePlugin::findRepositoryForDirectory():
+    // neither the root nor the home directory are considered.
+    static const QString root = QDir::rootPath();
+    static const QString home = QDir::homePath();
+
+    QString dir = QDir::cleanPath(QDir(directory).absolutePath());
+    QVector<QString> uncached;
+    QString found;
+
+    QMutexLocker locker(&m_mutex);
+    const qint64 now = m_clock.elapsed();
+    while (!dir.isEmpty() && dir != root && dir != home) {
+        const auto it = m_entries.constFind(dir);
+        if (it != m_entries.constEnd() && it->expiresMs > now) {
+            found = it->topLevel;
+            break;
+        }
+
+        // Do not hold up other threads while stat-ing
+        locker.unlock();
+        const bool isTopLevel = QFileInfo(dir + '/' + Constants::FOSSILREPO).isFile();
+        locker.relock();
+
+        uncached.append(dir);
+        if (isTopLevel) {
+            found = dir;
+            break;
+        }
+
+        const int slash = dir.lastIndexOf('/');
+        if (slash < 0)
+            break;
+        dir = (slash == 0) ? root : dir.left(slash);
+        // Drive roots (C:) keep their trailing slash
+        if (Utils::HostOsInfo::isWindowsHost() && dir.endsWith(':'))
+            dir += '/';
+    }
+
+    Entry entry;
+    entry.topLevel = found;
+    entry.expiresMs = now + (found.isEmpty() ? negativeEntryTtlMs : positiveEntryTtlMs);
+    for (const QString &path : uncached)
+        m_entries.insert(path, entry);
+    locker.unlock();
+
+    if (!found.isEmpty() && !uncached.isEmpty()) {
+        // The watcher is not thread-safe, let the owning thread set it up.
+        if (QThread::currentThread() == thread())
+            watchTopLevel(found);
+        else
+            emit topLevelFound(found);
+    }
+    return found;
+}
+
+bool TopLevelCache::isFile(const QString &path)
+{
+    const int slash = path.lastIndexOf('/');
+    if (slash < 0)
+        return QFileInfo(path).isFile();
+    QString directory = (slash == 0) ? QDir::rootPath() : path.left(slash);
+    // Drive roots (C:) keep their trailing slash
+    if (Utils::HostOsInfo::isWindowsHost() && directory.endsWith(':'))
+        directory += '/';
+    const QString name = fileNameKey(path.mid(slash + 1));
+
+    QMutexLocker locker(&m_mutex);
+    auto it = m_listings.find(directory);
+    if (it == m_listings.end()) {
+        locker.unlock();
+        // The watcher is not thread-safe, let the owning thread list the directory.
+        if (QThread::currentThread() != thread()) {
+            emit directoryQueried(directory);
+            return QFileInfo(path).isFile();
+        }
+        listDirectory(directory);
+        locker.relock();
+        it = m_listings.find(directory);
+        if (it == m_listings.end())
+            return false; // not a directory
+    }
+    it->lastUsed = ++m_useCount;
+    return it->files.contains(name);
+}
+
+void TopLevelCache::invalidate(const QString &directory)
+{
+    const QString dir = QDir::cleanPath(QDir(directory).absolutePath());
+    const QString prefix = dir.endsWith('/') ? dir : dir + '/';
+
+    QMutexLocker locker(&m_mutex);
+    for (auto it = m_entries.begin(); it != m_entries.end(); ) {
+        if (it.key() == dir || it.key().startsWith(prefix))
+            it = m_entries.erase(it);
+        else
+            ++it;
+    }
+    bool dropped = false;
+    for (auto it = m_listings.begin(); it != m_listings.end(); ) {
+        if (it.key() == dir || it.key().startsWith(prefix)) {
+            it = m_listings.erase(it);
+            dropped = true;
+        } else {
+            ++it;
+        }
+    }
+    locker.unlock();
+
+    if (dropped)
+        emit listingsDropped();
+}
+
+void TopLevelCache::clear()
+{
+    QMutexLocker locker(&m_mutex);
+    m_entries.clear();
+    m_listings.clear();
+    locker.unlock();
+
+    emit listingsDropped();
+}
+
+void TopLevelCache::watchTopLevel(const QString &topLevel)
+{
+    const QString checkoutFile = topLevel + '/' + Constants::FOSSILREPO;
+    if (!m_watcher->watchesFile(checkoutFile))
+        m_watcher->addFile(checkoutFile, Utils::FileSystemWatcher::WatchAllChanges);
+}
+
+void TopLevelCache::checkoutFileChanged(const QString &checkoutFile)
+{
+    // The checkout database is modified all the time, only its removal
+    // (fossil close) is of interest.
+    if (QFileInfo::exists(checkoutFile))
+        return;
+
+    m_watcher->removeFile(checkoutFile);
+    const QString topLevel = QFileInfo(checkoutFile).absolutePath();
+
+    QMutexLocker locker(&m_mutex);
+    for (auto it = m_entries.begin(); it != m_entries.end(); ) {
+        if (it->topLevel == topLevel)
+            it = m_entries.erase(it);
+        else
+            ++it;
+    }
+}
+
+void TopLevelCache::listDirectory(const QString &directory)
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        if (m_listings.contains(directory))
+            return;
+    }
+    if (!QFileInfo(directory).isDir())
+        return;
+
+    // Watch before listing, so that no change in between goes unnoticed
+    if (!m_watcher->watchesDirectory(directory))
+        m_watcher->addDirectory(directory, Utils::FileSystemWatcher::WatchAllChanges);
+
+    Listing listing;
+    const QStringList files = QDir(directory).entryList(QDir::Files | QDir::Hidden | QDir::System);
+    listing.files.reserve(files.size());
+    for (const QString &file : files)
+        listing.files.insert(fileNameKey(file));
+
+    QMutexLocker locker(&m_mutex);
+    listing.lastUsed = ++m_useCount;
+    m_listings.insert(directory, listing);
+
+    // Drop the least recently used listing
+    if (m_listings.size() <= maxListedDirectories)
+        return;
+    auto oldest = m_listings.begin();
+    for (auto it = m_listings.begin(); it != m_listings.end(); ++it) {
+        if (it->lastUsed < oldest->lastUsed)
+            oldest = it;
+    }
+    const QString dropped = oldest.key();
+    m_listings.erase(oldest);
+    locker.unlock();
+
+    m_watcher->removeDirectory(dropped);
+}
+
+void TopLevelCache::directoryChanged(const QString &directory)
+{
+    QMutexLocker locker(&m_mutex);
+    m_listings.remove(directory);
+    locker.unlock();
+
+    m_watcher->removeDirectory(directory);
+}
+
+void TopLevelCache::unwatchDroppedDirectories()
+{
+    QStringList dropped;
+    {
+        QMutexLocker locker(&m_mutex);
+        for (const QString &directory : m_watcher->directories()) {
+            if (!m_listings.contains(directory))
+                dropped << directory;
+        }
+    }
+    if (!dropped.isEmpty())
+        m_watcher->removeDirectories(dropped);
+}
+
+} // namespace Internal
+} // namespace Fossil
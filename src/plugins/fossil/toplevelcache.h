@@ -0,0 +1,105 @@
+/**************************************************************************
+**  This file is part of Fossil VCS plugin for Qt Creator
+**
+**  Copyright (c) 2013 - 2017, Artur Shepilko, <qtc-fossil@nomadbyte.com>.
+**
+**  Based on Bazaar VCS plugin for Qt Creator by Hugues Delorme.
+**
+**  Permission is hereby granted, free of charge, to any person obtaining a copy
+**  of this software and associated documentation files (the "Software"), to deal
+**  in the Software without restriction, including without limitation the rights
+**  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+**  copies of the Software, and to permit persons to whom the Software is
+**  furnished to do so, subject to the following conditions:
+**
+**  The above copyright notice and this permission notice shall be included in
+**  all copies or substantial portions of the Software.
+**
+**  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+**  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+**  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+**  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+**  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+**  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+**  THE SOFTWARE.
+**************************************************************************/
+
+#pragma once
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QMutex>
+#include <QObject>
+#include <QSet>
+
+namespace Utils { class FileSystemWatcher; }
+
+namespace Fossil {
+namespace Internal {
+
+// Maps directories to the top-level of the checkout they belong to, so that
+// resolving a directory does not stat for the checkout file on every level
+// of its path each time. Directories outside of any checkout are cached
+// too, but only for a while, as a checkout may be opened there any time.
+// Entries of a checkout are dropped once its checkout file is removed, and
+// expire after a longer while, so that a checkout opened below one already
+// cached (which creates no file the watcher knows of) is found as well.
+// Also lists the files of recently queried directories, so that classifying
+// paths takes a single directory listing instead of a stat per path. Listed
+// directories are watched and listed anew once changed.
+// May be queried from any thread.
+class TopLevelCache : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit TopLevelCache(QObject *parent = nullptr);
+
+    QString topLevel(const QString &directory);
+    bool isFile(const QString &path);
+
+    // Drops the entries of directory and anything below it,
+    // to be called once a checkout is created or opened there.
+    void invalidate(const QString &directory);
+    void clear();
+
+    static const int negativeEntryTtlMs = 30 * 1000;
+    static const int positiveEntryTtlMs = 5 * 60 * 1000;
+    static const int maxListedDirectories = 256;
+
+signals:
+    void topLevelFound(const QString &topLevel);
+    void directoryQueried(const QString &directory);
+    void listingsDropped();
+
+private:
+    struct Entry
+    {
+        QString topLevel;
+        qint64 expiresMs = 0;
+    };
+
+    struct Listing
+    {
+        QSet<QString> files;
+        quint64 lastUsed = 0;
+    };
+
+    void watchTopLevel(const QString &topLevel);
+    void checkoutFileChanged(const QString &checkoutFile);
+    void listDirectory(const QString &directory);
+    void directoryChanged(const QString &directory);
+    void unwatchDroppedDirectories();
+
+    Utils::FileSystemWatcher *m_watcher;
+    QMutex m_mutex;
+    QHash<QString, Entry> m_entries;
+    QHash<QString, Listing> m_listings;
+    quint64 m_useCount = 0;
+    QElapsedTimer m_clock;
+
+    friend class FossilPlugin;
+};
+
+} // namespace Internal
+} // namespace Fossil
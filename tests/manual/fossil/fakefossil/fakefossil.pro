@@ -0,0 +1,5 @@
+QT = core
+CONFIG += console
+CONFIG -= app_bundle
+TARGET = fakefossil
+SOURCES += main.cpp
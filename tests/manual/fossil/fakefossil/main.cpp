@@ -0,0 +1,208 @@
+/**************************************************************************
+**  This file is part of Fossil VCS plugin for Qt Creator
+**
+**  Copyright (c) 2013 - 2017, Artur Shepilko, <qtc-fossil@nomadbyte.com>.
+**
+**  Based on Bazaar VCS plugin for Qt Creator by Hugues Delorme.
+**
+**  Permission is hereby granted, free of charge, to any person obtaining a copy
+**  of this software and associated documentation files (the "Software"), to deal
+**  in the Software without restriction, including without limitation the rights
+**  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+**  copies of the Software, and to permit persons to whom the Software is
+**  furnished to do so, subject to the following conditions:
+**
+**  The above copyright notice and this permission notice shall be included in
+**  all copies or substantial portions of the Software.
+**
+**  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+**  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+**  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+**  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+**  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+**  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+**  THE SOFTWARE.
+**************************************************************************/
+
+// Stands in for the fossil binary in deterministic performance tests.
+//
+// The outputs are replayed from the script named by FAKE_FOSSIL_SCRIPT:
+//
+// {
+//     "rules": [
+//         { "match": "^changes", "outputFile": "changes.out", "repeat": 100,
+//           "delayMs": 50, "lineDelayMs": 0, "exitCode": 0 },
+//         { "match": "^timeline", "output": "...", "error": "...", "padBytes": 65536 }
+//     ]
+// }
+//
+// The first rule whose "match" expression matches the space-joined arguments
+// is used: after "delayMs" the output ("output" or the contents of
+// "outputFile", relative to the script) is written "repeat" times, optionally
+// padded with "padBytes" filler lines and paced by "lineDelayMs" per line.
+// Then "error" goes to stderr and the process exits with "exitCode".
+// With "markerFile" set, "started" and "finished" lines are appended to that
+// file, so that a test can tell whether the process was killed.
+// Without a matching rule "version" reports a fixed version, anything else fails.
+//
+// With FAKE_FOSSIL_REAL set to a real fossil binary the calls are passed on to it
+// instead and recorded as rules appended to the script, their outputs saved
+// next to it and their duration kept as the delay.
+
+#include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QProcess>
+#include <QRegularExpression>
+#include <QThread>
+
+#include <cstdio>
+
+static const char versionOutput[] =
+        "This is fossil version 2.10 [fakefossil] 2019-10-04 14:27:21 UTC\n";
+
+static void writeOut(const QByteArray &data, FILE *stream = stdout)
+{
+    fwrite(data.constData(), 1, size_t(data.size()), stream);
+}
+
+static QJsonObject readScript(const QString &fileName)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly))
+        return QJsonObject();
+    return QJsonDocument::fromJson(file.readAll()).object();
+}
+
+static void mark(const QJsonObject &rule, const QDir &scriptDir, const QByteArray &line)
+{
+    const QString markerFile = rule.value("markerFile").toString();
+    if (markerFile.isEmpty())
+        return;
+    QFile file(scriptDir.absoluteFilePath(markerFile));
+    if (file.open(QIODevice::WriteOnly | QIODevice::Append))
+        file.write(line + '\n');
+}
+
+static int replay(const QJsonObject &rule, const QDir &scriptDir)
+{
+    mark(rule, scriptDir, "started");
+    QThread::msleep(ulong(rule.value("delayMs").toInt()));
+
+    QByteArray output = rule.value("output").toString().toUtf8();
+    const QString outputFile = rule.value("outputFile").toString();
+    if (!outputFile.isEmpty()) {
+        QFile file(scriptDir.absoluteFilePath(outputFile));
+        if (!file.open(QIODevice::ReadOnly)) {
+            writeOut("fakefossil: cannot read " + file.fileName().toLocal8Bit() + '\n', stderr);
+            return 1;
+        }
+        output = file.readAll();
+    }
+    output = output.repeated(qMax(1, rule.value("repeat").toInt(1)));
+
+    const int padBytes = rule.value("padBytes").toInt();
+    if (padBytes > 0) {
+        const QByteArray line(79, '.');
+        for (int written = 0; written < padBytes; written += line.size() + 1)
+            output += line + '\n';
+    }
+
+    const int lineDelayMs = rule.value("lineDelayMs").toInt();
+    if (lineDelayMs > 0) {
+        int start = 0;
+        while (start < output.size()) {
+            int end = output.indexOf('\n', start);
+            end = (end < 0) ? output.size() : end + 1;
+            writeOut(output.mid(start, end - start));
+            fflush(stdout);
+            QThread::msleep(ulong(lineDelayMs));
+            start = end;
+        }
+    } else {
+        writeOut(output);
+    }
+    fflush(stdout);
+
+    writeOut(rule.value("error").toString().toUtf8(), stderr);
+    mark(rule, scriptDir, "finished");
+    return rule.value("exitCode").toInt();
+}
+
+static int record(const QString &realBinary, const QStringList &arguments,
+                  const QString &scriptFile)
+{
+    QElapsedTimer timer;
+    timer.start();
+    QProcess process;
+    process.start(realBinary, arguments);
+    if (!process.waitForFinished(-1)) {
+        writeOut("fakefossil: cannot run " + realBinary.toLocal8Bit() + '\n', stderr);
+        return 1;
+    }
+    const qint64 elapsedMs = timer.elapsed();
+    const QByteArray output = process.readAllStandardOutput();
+    const QByteArray error = process.readAllStandardError();
+    writeOut(output);
+    writeOut(error, stderr);
+    const int exitCode = process.exitStatus() == QProcess::NormalExit ? process.exitCode() : 1;
+
+    const QString joined = arguments.join(' ');
+    const QFileInfo script(scriptFile);
+    const QString outputFile = QString::fromLatin1(
+                QCryptographicHash::hash(joined.toUtf8(), QCryptographicHash::Sha1).toHex()) + ".out";
+    QFile out(script.absoluteDir().absoluteFilePath(outputFile));
+    if (!out.open(QIODevice::WriteOnly) || out.write(output) < 0)
+        return exitCode;
+
+    QJsonObject rule;
+    rule.insert("match", '^' + QRegularExpression::escape(joined) + '$');
+    rule.insert("outputFile", outputFile);
+    rule.insert("error", QString::fromUtf8(error));
+    rule.insert("exitCode", exitCode);
+    rule.insert("delayMs", int(elapsedMs));
+
+    QJsonObject root = readScript(scriptFile);
+    QJsonArray rules = root.value("rules").toArray();
+    rules.append(rule);
+    root.insert("rules", rules);
+    QFile file(scriptFile);
+    if (file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        file.write(QJsonDocument(root).toJson());
+    return exitCode;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    const QStringList arguments = app.arguments().mid(1);
+    const QString scriptFile = QString::fromLocal8Bit(qgetenv("FAKE_FOSSIL_SCRIPT"));
+
+    const QString realBinary = QString::fromLocal8Bit(qgetenv("FAKE_FOSSIL_REAL"));
+    if (!realBinary.isEmpty() && !scriptFile.isEmpty())
+        return record(realBinary, arguments, scriptFile);
+
+    const QString joined = arguments.join(' ');
+    if (!scriptFile.isEmpty()) {
+        const QJsonArray rules = readScript(scriptFile).value("rules").toArray();
+        for (const QJsonValue &value : rules) {
+            const QJsonObject rule = value.toObject();
+            const QRegularExpression match(rule.value("match").toString());
+            if (match.isValid() && match.match(joined).hasMatch())
+                return replay(rule, QFileInfo(scriptFile).absoluteDir());
+        }
+    }
+
+    if (arguments.value(0) == "version") {
+        writeOut(versionOutput);
+        return 0;
+    }
+    writeOut("fakefossil: no rule for \"" + joined.toLocal8Bit() + "\"\n", stderr);
+    return 1;
+}